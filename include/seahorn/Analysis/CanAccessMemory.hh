@@ -3,12 +3,13 @@
 
 /**
  * Identifies which functions may access to memory
+ * A view of the ModuleSummary
  */
 
 #include "llvm/Pass.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Function.h"
-#include "llvm/ADT/DenseSet.h"
+#include "seahorn/Analysis/ModuleSummary.hh"
 
 namespace seahorn
 {
@@ -16,21 +17,19 @@ namespace seahorn
   
   class CanAccessMemory : public ModulePass
   {
-    /// functions that must access memory
-    DenseSet<const Function*> m_must;
-    /// functions that may access memory
-    DenseSet<const Function*> m_may;
+    const ModuleSummary *m_summary;
     
   public:
     static char ID;
     
-    CanAccessMemory () : ModulePass (ID) {}
+    CanAccessMemory () : ModulePass (ID), m_summary (nullptr) {}
     
     virtual bool runOnModule (Module &M);
     virtual void getAnalysisUsage (AnalysisUsage &AU) const;
-    bool canAccess (const Function *f) const;
+    bool canAccess (const Function *f) const
+    {return m_summary->mayAccessMemory (f);}
     bool mustAccess (const Function *f) const
-    {return m_must.count (f) > 0;}
+    {return m_summary->mustAccessMemory (f);}
     
   };
 }
@@ -3,11 +3,12 @@
 
 /**
  * Identifies which functions may fail because of a call to verifier.error()
+ * A view of the ModuleSummary
  */
 #include "llvm/Pass.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Function.h"
-#include "llvm/ADT/DenseSet.h"
+#include "seahorn/Analysis/ModuleSummary.hh"
 
 namespace seahorn
 {
@@ -15,21 +16,19 @@ namespace seahorn
   
   class CanFail : public ModulePass
   {
-    /// functions that must fail
-    DenseSet<const Function*> m_must;
-    /// functions that may fail
-    DenseSet<const Function*> m_may;
+    const ModuleSummary *m_summary;
     
   public:
     static char ID;
     
-    CanFail () : ModulePass (ID) {}
+    CanFail () : ModulePass (ID), m_summary (nullptr) {}
     
     virtual bool runOnModule (Module &M);
     virtual void getAnalysisUsage (AnalysisUsage &AU) const;
-    bool canFail (const Function *f) const;
+    bool canFail (const Function *f) const
+    {return m_summary->mayFail (f);}
     bool mustFail (const Function *f) const
-    {return m_must.count (f) > 0;}
+    {return m_summary->mustFail (f);}
     
   };
 }
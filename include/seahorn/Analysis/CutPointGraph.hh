@@ -6,13 +6,13 @@
 #include "llvm/Pass.h"
 #include "llvm/IR/Function.h"
 #include "llvm/ADT/DenseMap.h"
-#include "llvm/ADT/BitVector.h"
 
 #include "boost/shared_ptr.hpp"
 #include "boost/make_shared.hpp"
 #include "boost/iterator/indirect_iterator.hpp"
 
 #include "seahorn/Analysis/TopologicalOrder.hh"
+#include "seahorn/Support/BitSet.hh"
 namespace seahorn
 {
   using namespace llvm;
@@ -119,11 +119,17 @@ namespace seahorn
     CpVector m_cps;
     CpEdgeVector m_edges;
     
-    typedef DenseMap<const BasicBlock*, BitVector> BlockBitMap;
-    /// maps a basic block to ids of cut-points it can forward reach
-    BlockBitMap m_fwd;
-    /// maps a basic block to ids of cut-points that can reach it
-    BlockBitMap m_bwd;
+    /// all indexed by the number of a block in TopologicalOrder::cfg
+    typedef std::vector<BitSet> BlockBits;
+    /// ids of cut-points a basic block can forward reach
+    BlockBits m_fwd;
+    /// ids of cut-points that can reach a basic block
+    BlockBits m_bwd;
+    /// id of the cut-point at a basic block, or -1
+    std::vector<int> m_cpId;
+    /// number of a basic block in TopologicalOrder::cfg. Kept here
+    /// since the TopologicalOrder may be released before queries
+    DenseMap<const BasicBlock*, unsigned> m_num;
     
     
     DenseMap<const BasicBlock*,  CutPoint *> m_bb;
@@ -173,7 +179,11 @@ namespace seahorn
     virtual void getAnalysisUsage (AnalysisUsage &AU) const;
     virtual bool runOnFunction (Function &F);
     virtual void releaseMemory () 
-    { m_cps.clear (); m_edges.clear (); m_bb.clear (); }
+    { 
+      m_cps.clear (); m_edges.clear (); m_bb.shrink_and_clear (); 
+      BlockBits ().swap (m_fwd); BlockBits ().swap (m_bwd);
+      std::vector<int> ().swap (m_cpId); m_num.shrink_and_clear ();
+    }
     
     bool isCutPoint (const BasicBlock &bb) const
     {
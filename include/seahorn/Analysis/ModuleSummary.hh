@@ -0,0 +1,94 @@
+#ifndef _MODULE_SUMMARY__HH_
+#define _MODULE_SUMMARY__HH_
+
+/**
+ * Per-function facts gathered in a single sweep over the module:
+ * may fail, reads undef, accesses memory, calls error, seahorn.fail
+ * or assume, has loops.
+ *
+ * The summary is computed once per pass manager run. Many
+ * transformations declare setPreservesAll, so the pass manager keeps
+ * the summary alive across them. Such a transformation that adds or
+ * removes calls, memory accesses, undef operands, loops or functions
+ * must call invalidate () on the summary, if it is available.
+ */
+#include "llvm/Pass.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Function.h"
+#include "llvm/ADT/DenseMap.h"
+
+namespace seahorn
+{
+  using namespace llvm;
+
+  class ModuleSummary : public ModulePass
+  {
+  public:
+    enum Flag
+    {
+      /// the function is verifier.error
+      MUST_FAIL = 1 << 0,
+      /// the function may (transitively) call verifier.error
+      MAY_FAIL = 1 << 1,
+      /// an operand of some instruction is undef
+      READS_UNDEF = 1 << 2,
+      /// the function loads, stores, or calls a memory intrinsic
+      MUST_ACCESS_MEM = 1 << 3,
+      /// the function may (transitively) access memory
+      MAY_ACCESS_MEM = 1 << 4,
+      CALLS_ERROR = 1 << 5,
+      CALLS_SEAHORN_FAIL = 1 << 6,
+      CALLS_ASSUME = 1 << 7,
+      HAS_LOOP = 1 << 8
+    };
+
+  private:
+    DenseMap<const Function*, unsigned> m_flags;
+    bool m_valid;
+
+    void compute (Module &M);
+
+  public:
+    static char ID;
+
+    ModuleSummary () : ModulePass (ID), m_valid (false) {}
+
+    virtual bool runOnModule (Module &M);
+    virtual void getAnalysisUsage (AnalysisUsage &AU) const;
+    virtual const char* getPassName () const {return "ModuleSummary";}
+
+    /// recompute the summary if it has been invalidated. Clients
+    /// call this before reading the summary
+    void refresh (Module &M);
+    /// mark the summary as out of date. Called by transformations
+    /// that preserve all analyses but change what the summary records
+    void invalidate () {m_valid = false;}
+
+    unsigned flags (const Function *f) const
+    {
+      auto it = m_flags.find (f);
+      return it == m_flags.end () ? 0 : it->second;
+    }
+    bool has (const Function *f, Flag flag) const
+    {return (flags (f) & flag) != 0;}
+
+    bool mustFail (const Function *f) const {return has (f, MUST_FAIL);}
+    bool mayFail (const Function *f) const
+    {return (flags (f) & (MUST_FAIL | MAY_FAIL)) != 0;}
+    bool readsUndef (const Function *f) const {return has (f, READS_UNDEF);}
+    bool mustAccessMemory (const Function *f) const
+    {return has (f, MUST_ACCESS_MEM);}
+    bool mayAccessMemory (const Function *f) const
+    {return (flags (f) & (MUST_ACCESS_MEM | MAY_ACCESS_MEM)) != 0;}
+    bool callsError (const Function *f) const {return has (f, CALLS_ERROR);}
+    bool callsSeahornFail (const Function *f) const
+    {return has (f, CALLS_SEAHORN_FAIL);}
+    bool callsAssume (const Function *f) const {return has (f, CALLS_ASSUME);}
+    bool hasLoop (const Function *f) const {return has (f, HAS_LOOP);}
+
+    /// true if some function other than verifier.error and
+    /// seahorn.fail may fail
+    bool anyMayFail (const Module &M) const;
+  };
+}
+#endif /* _MODULE_SUMMARY__HH_ */
@@ -1,42 +1,29 @@
 #ifndef __CLP_SYM_EXEC_HH_
 #define __CLP_SYM_EXEC_HH_
 
-/* Based on a copy-and-paste version of UfoSymExec */
+/* Shares the semantics of values with UfoSymExec (SmallSymExecCore) */
 
-#include "llvm/Pass.h"
-#include "llvm/IR/DataLayout.h"
-#include "seahorn/SymExec.hh"
-#include "seahorn/Analysis/CanFail.hh"
+#include "seahorn/SmallSymExecCore.hh"
 
 namespace seahorn
 {
   
   /// Small step symbolic execution for integers based on CLP semantics
-  class ClpSmallSymExec : public SmallStepSymExec
+  class ClpSmallSymExec : public SmallSymExecCore<ClpSmallSymExec>
   { 
-    Pass &m_pass;
-    TrackLevel m_trackLvl;
-   
-    const DataLayout *m_td;
-    const CanFail *m_canFail;
-
     Expr zero;
     Expr one;
     
   public:
     ClpSmallSymExec (ExprFactory &efac, Pass &pass, TrackLevel trackLvl = MEM) : 
-      SmallStepSymExec (efac), m_pass (pass), m_trackLvl (trackLvl)
+      SmallSymExecCore (efac, pass, trackLvl)
     {
-      m_td = &pass.getAnalysis<DataLayoutPass> ().getDataLayout ();
-      m_canFail = pass.getAnalysisIfAvailable<CanFail> ();
       zero = mkTerm<mpz_class> (0, m_efac);
       one  = mkTerm<mpz_class> (1, m_efac);
     }
 
     ClpSmallSymExec (const ClpSmallSymExec& o) : 
-      SmallStepSymExec (o), m_pass (o.m_pass), m_trackLvl (o.m_trackLvl) {}
-    
-    Expr errorFlag (const BasicBlock &BB) override;
+      SmallSymExecCore (o), zero (o.zero), one (o.one) {}
     
     virtual void exec (SymStore &s, const BasicBlock &bb, 
                        ExprVector &side, Expr act);
@@ -47,22 +34,11 @@ namespace seahorn
     virtual void execPhi (SymStore &s, const BasicBlock &bb, 
                           const BasicBlock &from, ExprVector &side, Expr act);
     
-    virtual void execEdg (SymStore &s, const BasicBlock &src,
-                          const BasicBlock &dst, ExprVector &side);
-    
-    virtual void execBr (SymStore &s, const BasicBlock &src, const BasicBlock &dst,
-                         ExprVector &side, Expr act);
-    
-    virtual Expr symb (const Value &v);
-    virtual const Value &conc (Expr v);
-    virtual bool isTracked (const Value &v);
-    virtual Expr lookup (SymStore &s, const Value &v);
-    
-    Expr ptrArith (SymStore &s, const Value& base, 
-                   SmallVectorImpl<const Value*> &ps,
-                   SmallVectorImpl<const Type *> &ts);
-    unsigned storageSize (const llvm::Type *t);
-    unsigned fieldOff (const StructType *t, unsigned field);
+    /// -- policy of SmallSymExecCore. Constraints are never guarded
+    static bool shadowMem (const Value &v, const Value **scalar);
+    static Expr negate (Expr e);
+    static Expr guard (Expr act, Expr e)
+    { assert (isOpX<TRUE> (act)); return e; }
   }; 
   
 }
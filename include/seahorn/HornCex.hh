@@ -4,6 +4,9 @@
 #include "llvm/Pass.h"
 #include "llvm/IR/Module.h"
 
+#include "ufo/Expr.hpp"
+#include <map>
+
 namespace seahorn
 {
   using namespace llvm;
@@ -13,9 +16,18 @@ namespace seahorn
    */
   class HornCex : public llvm::ModulePass
   {
+  public:
+    /// values returned by every nondet function, in call order
+    typedef std::map<const Function*, expr::ExprVector> NondetValues;
+
+  private:
     void printInvars (Function &F);
     void printInvars (Module &M);
     void printCex ();
+    bool groundCex (Function &F,
+                    const std::vector<const BasicBlock*> &bbTrace,
+                    std::vector<const BasicBlock*> &cex,
+                    NondetValues &nondet);
     
   public:
     static char ID;
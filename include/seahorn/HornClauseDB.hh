@@ -93,15 +93,29 @@ namespace seahorn
     ExprFactory &m_efac;
     ExprVector m_rels;
     mutable ExprVector m_vars;
+    /// size of m_vars after its duplicates were last removed
+    mutable size_t m_uniqVars;
     RuleVector m_rules;
     ExprVector m_queries;
     std::map<Expr, ExprVector> m_constraints;
+    /// bound variables of the arguments of every relation
+    mutable std::map<Expr, ExprVector> m_bvars;
     
     const ExprVector &getVars () const;
+    const ExprVector &bvars (Expr reln) const;
+    
+    /// adds the variables of a rule. Most variables are shared by
+    /// many rules, so duplicates are dropped whenever m_vars doubles
+    template <typename Range>
+    void addVars (const Range &vars)
+    {
+      boost::copy (vars, std::back_inserter (m_vars));
+      if (m_vars.size () > 2 * m_uniqVars + 1024) getVars ();
+    }
     
   public:
 
-    HornClauseDB (ExprFactory &efac) : m_efac (efac) {}
+    HornClauseDB (ExprFactory &efac) : m_efac (efac), m_uniqVars (0) {}
     
     ExprFactory &getExprFactory () {return m_efac;}
     
@@ -112,6 +126,9 @@ namespace seahorn
         (m_rels.begin (), m_rels.end (), fdecl) != m_rels.end ();}
     /// number of relational predicates
     unsigned relSize () { return m_rels.size ();}
+    /// removes a relation together with its constraints. Rules that
+    /// use the relation are not changed
+    void removeRelation (Expr fdecl);
     
     
     template <typename Range>
@@ -119,13 +136,13 @@ namespace seahorn
     {
       if (isOpX<TRUE> (rule)) return;
       m_rules.push_back (HornRule (vars, rule));
-      boost::copy (vars, std::back_inserter (m_vars));
+      addVars (vars);
     }
 
     void addRule (HornRule rule)
     {
       m_rules.push_back (rule);
-      boost::copy (rule.vars (), std::back_inserter (m_vars));
+      addVars (rule.vars ());
     }
     
     const ExprVector &getVars ()
@@ -133,6 +150,7 @@ namespace seahorn
       // -- remove duplicates
       std::sort (m_vars.begin (), m_vars.end ());
       m_vars.erase (std::unique (m_vars.begin (), m_vars.end ()), m_vars.end ());
+      m_uniqVars = m_vars.size ();
       
       return m_vars;
     }
@@ -9,6 +9,27 @@ namespace seahorn
   // Ensure all horn clause heads have only variables
   void normalizeHornClauseHeads (HornClauseDB &db);
 
+  // Rewrite the body of every horn clause into a simplified normal form
+  void simplifyHornClauseBodies (HornClauseDB &db);
+
+  /// Signature of a function summary relation. The first three
+  /// arguments (enabled, incoming and outgoing error flag) are reserved
+  struct SummarySignature
+  {
+    /// the summary relation. Replaced by the narrowed relation
+    Expr rel;
+    /// arguments written by the callee (outgoing regions, return value)
+    std::vector<bool> output;
+    /// position in the original relation of every argument of rel
+    std::vector<unsigned> kept;
+  };
+
+  // Narrow summary relations: drop arguments that are unconstrained
+  // by the callee or unused by all callers, and merge outgoing
+  // arguments that always equal an incoming one (e.g., regions that
+  // the callee only reads) into the incoming argument
+  void minimizeSummaries (HornClauseDB &db, std::vector<SummarySignature> &sums);
+
 }
 
 
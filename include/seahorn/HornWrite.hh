@@ -12,10 +12,10 @@ namespace seahorn
   
   class HornWrite : public llvm::ModulePass
   {
-    llvm::raw_fd_ostream& m_out;
+    llvm::raw_ostream& m_out;
   public:
     static char ID;
-    HornWrite (llvm::raw_fd_ostream &out) : llvm::ModulePass (ID), m_out (out) {}
+    HornWrite (llvm::raw_ostream &out) : llvm::ModulePass (ID), m_out (out) {}
     virtual ~HornWrite () {} 
     virtual const char* getPassName () const {return "HornWrite";}
     
@@ -23,8 +23,13 @@ namespace seahorn
   
   class HornifyModule : public llvm::ModulePass
   {
-    typedef llvm::DenseMap<const Function*, LiveSymbols> LiveSymbolsMap;
-    typedef llvm::DenseMap<const BasicBlock*, Expr> PredDeclMap;
+    /// predicate and live symbols of a basic block
+    struct BlockInfo
+    {
+      /// NULL until the predicate is requested
+      Expr pred;
+      ExprVector live;
+    };
     
   protected:
     
@@ -36,8 +41,15 @@ namespace seahorn
     const CanFail *m_canFail;
     boost::scoped_ptr<SmallStepSymExec> m_sem;
     
-    LiveSymbolsMap m_ls;
-    PredDeclMap m_bbPreds;
+    /// live symbols of the function being hornified. Released once
+    /// the function is done
+    boost::scoped_ptr<LiveSymbols> m_ls;
+    /// cut-point graph of the function being hornified, if used
+    CutPointGraph *m_cpg;
+    /// blocks of the hornified functions, one contiguous range per
+    /// function, and the position of every block in it
+    std::vector<BlockInfo> m_blocks;
+    DenseMap<const BasicBlock*, unsigned> m_bbIdx;
     
   public:
     static char ID;
@@ -56,13 +68,18 @@ namespace seahorn
     /// -- live symbols for a basic block
     const ExprVector &live (const BasicBlock &bb) const
     {
-      return getLiveSybols (*bb.getParent ()).live (&bb);
+      auto it = m_bbIdx.find (&bb);
+      assert (it != m_bbIdx.end ());
+      return m_blocks [it->second].live;
     }
     /// --- live symbols for a basic block
     const ExprVector &live (const BasicBlock *bb) const 
     {assert (bb != NULL); return live (*bb);}
     bool hasBbPredicate (const BasicBlock &BB) const
-    {return m_bbPreds.count (&BB);} 
+    {
+      auto it = m_bbIdx.find (&BB);
+      return it != m_bbIdx.end () && m_blocks [it->second].pred;
+    }
     /// -- predicate declaration for the given basic block
     const Expr bbPredicate (const BasicBlock &bb);
     /// --- BasicBlock corresponding to the predicate
@@ -79,7 +96,10 @@ namespace seahorn
     SmallStepSymExec &symExec () {return *m_sem;}
     
     CutPointGraph &getCpg (Function &F)
-    {return getAnalysis<CutPointGraph> (F);}
+    {
+      m_cpg = &getAnalysis<CutPointGraph> (F);
+      return *m_cpg;
+    }
     
   };
 }
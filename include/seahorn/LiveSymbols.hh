@@ -8,6 +8,7 @@
 #include "ufo/Expr.hpp"
 #include "seahorn/SymStore.hh"
 #include "seahorn/SymExec.hh"
+#include "seahorn/Support/CfgSnapshot.hh"
 
 namespace seahorn
 {
@@ -68,7 +69,8 @@ namespace seahorn
     SmallStepSymExec& m_semantics;
     ExprVector m_side;
     
-    std::vector<const BasicBlock*> m_rtopo;
+    /// the CFG, blocks numbered in topological order
+    CfgSnapshot m_cfg;
     
     SymStore m_gstore;
     DenseMap<const BasicBlock*, LiveInfo> m_liveInfo;
@@ -93,7 +95,7 @@ namespace seahorn
     
     LiveSymbols (const LiveSymbols &o) : 
       m_f(o.m_f), m_efac (o.m_efac), m_semantics (o.m_semantics),
-      m_side(), m_rtopo (o.m_rtopo), m_gstore(o.m_gstore), m_liveInfo(o.m_liveInfo),
+      m_side(), m_cfg (o.m_cfg), m_gstore(o.m_gstore), m_liveInfo(o.m_liveInfo),
       trueE(o.trueE) {}
     
     
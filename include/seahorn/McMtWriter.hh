@@ -7,136 +7,330 @@
 
 #include "seahorn/config.h"
 
+#include <boost/lexical_cast.hpp>
+
 namespace seahorn
 {
+  /**
+   * Writes a linear Horn clause database as an MCMT (Sally)
+   * transition system.
+   *
+   * The database is flattened into a single transition system. A
+   * program counter (pc) identifies the current predicate. The
+   * arguments of all predicates share state variables: the k-th
+   * argument of sort S of a predicate is stored in the k-th state
+   * variable of sort S. Each rule becomes one transition, facts start
+   * from the initial location and queries go to the error location.
+   */
   template <typename Out>
   class McMtWriter
   {
     HornClauseDB &m_db;
     ExprFactory &m_efac;
     EZ3 &m_z3;
-    
+
     Expr trueE;
-    
+
+    /// -- reserved values of the program counter
+    enum { INIT_LOC = 0, ERR_LOC = 1 };
+
+    /// -- sort of every state variable. Slot 0 is the program counter
+    ExprVector m_stateTy;
+    /// -- sort of every input variable
+    ExprVector m_inputTy;
+    /// -- input variables of a given sort
+    std::map<Expr, std::vector<unsigned> > m_inputsBySort;
+    /// -- program counter value of every relation
+    std::map<Expr, unsigned> m_loc;
+    /// -- state variable of every argument of every relation
+    std::map<Expr, std::vector<unsigned> > m_slots;
+
   public:
     McMtWriter (HornClauseDB &db, EZ3 &z3) :
       m_db (db), m_efac(db.getExprFactory ()), m_z3(z3)
-    {trueE = mk<TRUE> (m_efac);} 
-    
+    {trueE = mk<TRUE> (m_efac);}
+
     Out &write (Out &out);
+
+  private:
+    bool isSupportedSort (Expr ty);
+    bool layout ();
+    bool splitBody (Expr body, Expr &pred, ExprVector &side);
+    void bindState (Expr pre, Expr post, const ExprVector &vars,
+                    ExprMap &sub, ExprVector &side);
+    void bindInputs (const ExprVector &vars, ExprMap &sub);
+    void queryVars (Expr q, ExprVector &vars);
+
+    Expr mkVar (const std::string &name, Expr ty)
+    { return bind::mkConst (mkTerm<std::string> (name, m_efac), ty); }
+
+    std::string stateName (unsigned slot)
+    {
+      if (slot == 0) return "pc";
+      return "s" + boost::lexical_cast<std::string> (slot - 1);
+    }
+    std::string inputName (unsigned idx)
+    { return "i" + boost::lexical_cast<std::string> (idx); }
+
+    Expr stateVar (unsigned slot, bool next)
+    {
+      return mkVar ((next ? "next." : "state.") + stateName (slot),
+                    m_stateTy [slot]);
+    }
+    Expr inputVar (unsigned idx)
+    { return mkVar ("input." + inputName (idx), m_inputTy [idx]); }
+    Expr mkLoc (unsigned loc)
+    { return mkTerm<mpz_class> (loc, m_efac); }
   };
 
   template <typename Out>
-  Out &McMtWriter<Out>::write (Out &out)
+  bool McMtWriter<Out>::isSupportedSort (Expr ty)
+  {
+    if (isOpX<BOOL_TY> (ty) || isOpX<REAL_TY> (ty) || isOpX<INT_TY> (ty))
+      return true;
+    if (isOpX<ARRAY_TY> (ty))
+      return isSupportedSort (sort::arrayIndexTy (ty)) &&
+        isSupportedSort (sort::arrayValTy (ty));
+    return false;
+  }
+
+  /// Assigns a location to every relation and a state variable to
+  /// every argument. Relations never hold at the same time, so their
+  /// arguments share state variables of the same sort.
+  template <typename Out>
+  bool McMtWriter<Out>::layout ()
+  {
+    m_stateTy.push_back (mk<INT_TY> (m_efac));
+
+    std::map<Expr, std::vector<unsigned> > bySort;
+    unsigned loc = ERR_LOC + 1;
+    for (Expr rel : m_db.getRelations ())
+    {
+      m_loc [rel] = loc++;
+      std::vector<unsigned> &slots = m_slots [rel];
+      std::map<Expr, unsigned> used;
+      for (unsigned i = 0, sz = bind::domainSz (rel); i < sz; ++i)
+      {
+        Expr ty = bind::domainTy (rel, i);
+        if (!isSupportedSort (ty))
+        {
+          errs () << "Unsupported type: " << *ty << " of argument " << i
+                  << " of " << *bind::fname (rel) << "\n";
+          return false;
+        }
+
+        std::vector<unsigned> &avail = bySort [ty];
+        unsigned k = used [ty]++;
+        if (k == avail.size ())
+        {
+          avail.push_back (m_stateTy.size ());
+          m_stateTy.push_back (ty);
+        }
+        slots.push_back (avail [k]);
+      }
+    }
+    return true;
+  }
+
+  /// Splits the body of a rule into the (unique) predicate
+  /// application and the side constraints. Returns false if the rule
+  /// is not linear.
+  template <typename Out>
+  bool McMtWriter<Out>::splitBody (Expr body, Expr &pred, ExprVector &side)
+  {
+    ExprVector todo;
+    todo.push_back (body);
+    while (!todo.empty ())
+    {
+      Expr e = todo.back ();
+      todo.pop_back ();
+
+      if (isOpX<AND> (e))
+        for (auto it = e->args_begin (), end = e->args_end (); it != end; ++it)
+          todo.push_back (*it);
+      else if (bind::isFapp (e) && m_db.hasRelation (bind::fname (e)))
+      {
+        if (pred) return false;
+        pred = e;
+      }
+      else if (!isOpX<TRUE> (e))
+        side.push_back (e);
+    }
+    return true;
+  }
+
+  /// Connects the arguments of the pre- and post-predicates to the
+  /// state variables. Variables that are passed directly are
+  /// substituted by their state variable, everything else gets an
+  /// equality. A null pre is the initial location, a null post the
+  /// error location.
+  template <typename Out>
+  void McMtWriter<Out>::bindState (Expr pre, Expr post,
+                                   const ExprVector &vars,
+                                   ExprMap &sub, ExprVector &side)
+  {
+    ExprSet bound (vars.begin (), vars.end ());
+
+    for (unsigned n = 0; n < 2; ++n)
+    {
+      bool next = n == 1;
+      Expr fapp = next ? post : pre;
+
+      unsigned loc = next ? ERR_LOC : INIT_LOC;
+      if (fapp) loc = m_loc [bind::fname (fapp)];
+      side.push_back (mk<EQ> (stateVar (0, next), mkLoc (loc)));
+      if (!fapp) continue;
+
+      const std::vector<unsigned> &slots = m_slots [bind::fname (fapp)];
+      for (unsigned i = 0, sz = slots.size (); i < sz; ++i)
+      {
+        Expr arg = fapp->arg (i + 1);
+        Expr v = stateVar (slots [i], next);
+        if (bound.count (arg) > 0 && sub.count (arg) == 0) sub [arg] = v;
+        else side.push_back (mk<EQ> (v, arg));
+      }
+    }
+  }
+
+  /// Maps the remaining variables of a rule to input variables,
+  /// reusing inputs of the same sort between rules.
+  template <typename Out>
+  void McMtWriter<Out>::bindInputs (const ExprVector &vars, ExprMap &sub)
+  {
+    std::map<Expr, unsigned> used;
+    for (Expr v : vars)
+    {
+      if (sub.count (v) > 0) continue;
+
+      Expr ty = bind::typeOf (v);
+      std::vector<unsigned> &avail = m_inputsBySort [ty];
+      unsigned k = used [ty]++;
+      if (k == avail.size ())
+      {
+        avail.push_back (m_inputTy.size ());
+        m_inputTy.push_back (ty);
+      }
+      sub [v] = inputVar (avail [k]);
+    }
+  }
+
+  /// Queries carry no explicit variables. Every constant that is not
+  /// a relation is implicitly quantified.
+  template <typename Out>
+  void McMtWriter<Out>::queryVars (Expr q, ExprVector &vars)
   {
+    ExprSet consts;
+    expr::filter (q, bind::IsConst (), std::inserter (consts, consts.begin ()));
+    for (Expr c : consts)
+      if (!m_db.hasRelation (bind::fname (c))) vars.push_back (c);
+  }
 
-    // XXX We assume that the CHC follow the specific flarge encoding.
+  template <typename Out>
+  Out &McMtWriter<Out>::write (Out &out)
+  {
     if (!m_db.hasQuery ()) return out;
 
-    
-    auto &vars = m_db.getVars ();
-    Expr query = m_db.getQueries ()[0];
-    Expr tr = bind::fname (query);
-    Expr errLoc = query->arg (1);
-    
-   
-    out << ";; SeaHorn v." << SEAHORN_VERSION_INFO << "\n";
-    out << "(define-state-type st_ty\n";
-    
-    out << "  (";
-    for (unsigned i=0,sz=bind::domainSz (tr); i < sz; ++i)
+    if (!layout ())
+    {
+      assert (false);
+      return out;
+    }
+
+    // -- first pass: check linearity and size the input variables
+    for (auto &r : m_db.getRules ())
     {
-      Expr ty = bind::domainTy (tr, i);
-      out << "(s" << i << " ";
-      if (isOpX<BOOL_TY> (ty)) out << "Bool";
-      else if (isOpX<REAL_TY> (ty)) out << "Real";
-      else if (isOpX<INT_TY> (ty)) out << "Int";
-      else
+      Expr pre;
+      ExprVector side;
+      if (!splitBody (r.body (), pre, side))
       {
-        errs () << "Unsupported type: " << "s" << i << " type " << *ty << "\n";
+        errs () << "Non-linear rule: " << *r.get () << "\n";
         assert (false);
         return out;
       }
-      out << ") ";
+      ExprMap sub;
+      bindState (pre, r.head (), r.vars (), sub, side);
+      bindInputs (r.vars (), sub);
     }
-    out << ")\n";
-    
 
-    // -- inputs
-    out << "  (";
-    for (auto v : vars)
+    for (Expr q : m_db.getQueries ())
     {
-      out << "(" << m_z3.toSmtLib (v) << " ";
-      
-      Expr ty = bind::typeOf (v);
-      if (isOpX<BOOL_TY> (ty)) out << "Bool";
-      else if (isOpX<REAL_TY> (ty)) out << "Real";
-      else if (isOpX<INT_TY> (ty)) out << "Int";
-      else
+      Expr pre;
+      ExprVector side, vars;
+      if (!splitBody (q, pre, side))
       {
-        errs () << "Unsupported type: " << m_z3.toSmtLib (v) << " type " << *ty << "\n";
+        errs () << "Non-linear query: " << *q << "\n";
         assert (false);
         return out;
       }
-      out << ") ";
+      queryVars (q, vars);
+      ExprMap sub;
+      bindState (pre, Expr (), vars, sub, side);
+      bindInputs (vars, sub);
     }
+
+    out << ";; SeaHorn v." << SEAHORN_VERSION_INFO << "\n";
+    out << "(define-state-type st_ty\n";
+
+    out << "  (";
+    for (unsigned i = 0, sz = m_stateTy.size (); i < sz; ++i)
+      out << "(" << stateName (i) << " "
+          << m_z3.toSmtLib (m_stateTy [i]) << ") ";
     out << ")\n";
-    
+
+    // -- inputs
+    out << "  (";
+    for (unsigned i = 0, sz = m_inputTy.size (); i < sz; ++i)
+      out << "(" << inputName (i) << " "
+          << m_z3.toSmtLib (m_inputTy [i]) << ") ";
     out << ")\n";
 
-    // -- initial state is pc=0
-    out << "(define-states init st_ty (= s0 0))\n";
+    out << ")\n";
 
+    out << "(define-states init st_ty (= pc " << INIT_LOC << "))\n";
+
+    // -- second pass: one transition per rule and per query. Each
+    // -- transition is written as soon as it is built
     unsigned c = 0;
+    auto writeTr = [&] (Expr pre, Expr post, const ExprVector &vars,
+                        ExprVector &side)
+      {
+        ExprMap sub;
+        bindState (pre, post, vars, sub, side);
+        bindInputs (vars, sub);
+
+        Expr phi = mknary<AND> (trueE, side);
+        phi = z3_simplify (m_z3, replace (phi, sub));
+        out << "(define-transition tr_" << c++ << " st_ty\n";
+        out << "  " << m_z3.toSmtLib (phi) << ")\n";
+      };
+
     for (auto &r : m_db.getRules ())
     {
-      // -- skip rules that do not define the main transition relation
-      if (bind::fname (r.head ()) != tr) continue;
-      // -- skip facts, we assume everything starts at pc=0
-      if (isOpX<TRUE> (r.body ())) continue;
-      
-      ExprVector body;
-      assert (isOpX<AND> (r.body ()));
-      for (unsigned i=1,sz=r.body ()->arity (); i < sz; ++i)
-        body.push_back (r.body ()->arg (i));
-      
-      out << "(define-transition " << *bind::fname (tr) << "_tr_" << c++
-          << " st_ty\n";
-
-      out << "(and \n";
-
-      // -- prev state
-      Expr st = r.body ()->arg (0);
-      out << "  ";
-      for (unsigned i=1, sz=st->arity (); i < sz; ++i)
-        out << "(= state.s" << (i-1) << " " << *st->arg(i) << ") ";
-      out << "\n";
-      
-      // -- next state
-      out << "  ";
-      for (unsigned i=1, sz=r.head()->arity(); i < sz; ++i)
-        out << "(= next.s" << (i-1) << " " << *r.head ()->arg (i) << ") ";
-      out << "\n";
-      
-      Expr phi = mknary<AND> (trueE, body);
-      phi = z3_simplify (m_z3, phi);
-      out << "  " << m_z3.toSmtLib (phi) << ")\n";
-      out << ")\n";
+      Expr pre;
+      ExprVector side;
+      splitBody (r.body (), pre, side);
+      writeTr (pre, r.head (), r.vars (), side);
     }
-    
-    out << "(define-transition-system " << *bind::fname (tr)
-        << " st_ty init \n";
-    out << "(or ";
-    for (unsigned i = 0; i < c; ++i)
-      out << *bind::fname (tr) << "_tr_" << i << " ";
+
+    for (Expr q : m_db.getQueries ())
+    {
+      Expr pre;
+      ExprVector side, vars;
+      splitBody (q, pre, side);
+      queryVars (q, vars);
+      writeTr (pre, Expr (), vars, side);
+    }
+
+    out << "(define-transition-system flat st_ty init\n";
+    out << "  (or false ";
+    for (unsigned i = 0; i < c; ++i) out << "tr_" << i << " ";
     out << "))\n";
-    
-    out << "(query " << *bind::fname (tr) << "  (< s0 "
-        << m_z3.toSmtLib (errLoc) << "))\n";
-    
+
+    out << "(query flat (not (= pc " << ERR_LOC << ")))\n";
+
     return out;
   }
-  
+
 }
 
 #endif /* _MCMT_WRITER__H_ */
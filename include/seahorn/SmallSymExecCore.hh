@@ -0,0 +1,485 @@
+#ifndef __SMALL_SYM_EXEC_CORE_HH_
+#define __SMALL_SYM_EXEC_CORE_HH_
+
+#include "llvm/Pass.h"
+#include "llvm/IR/DataLayout.h"
+#include "seahorn/SymExec.hh"
+#include "seahorn/Analysis/CanFail.hh"
+
+#include "ufo/ExprLinear.hpp"
+
+namespace seahorn
+{
+  /**
+   * Semantics of LLVM values shared by the small-step encodings:
+   * naming of values, tracking, pointer arithmetic and branch
+   * conditions. The instruction visitors are specific to an
+   * encoding and live in the derived class.
+   *
+   * Policy is the derived class. It provides
+   *
+   *   static bool shadowMem (const Value &v, const Value **scalar)
+   *     true if v is a shadow memory region. scalar is set to the
+   *     single scalar stored in the region, if the encoding tracks
+   *     such regions as registers
+   *
+   *   static Expr negate (Expr e)
+   *     negation of a branch condition
+   *
+   *   static Expr guard (Expr act, Expr e)
+   *     e under the activation literal act
+   *
+   * Calls and phi-nodes are encoded the same way by every small-step
+   * encoding and are shared by execCallSite and execPhis below. Their
+   * Visitor argument is the instruction visitor of the encoding. It
+   * has the members m_s, m_side, m_fparams, m_inMem, m_outMem and
+   * falseE, the functions lookup, havoc and visitInstruction, and
+   * the hooks
+   *
+   *   Expr activeLit ()
+   *     activation literal of the current instruction
+   *
+   *   bool execIntrinsic (CallSite CS, intrinsic::Kind kind)
+   *     encodes a call the encoding handles specially (e.g., calloc).
+   *     Returns false if the call is left to the shared code
+   *
+   *   void shadowMemAccess (CallSite CS, intrinsic::Kind kind)
+   *     called after a shadow.mem.load or shadow.mem.store has set
+   *     m_inMem and m_outMem
+   *
+   *   void definePhi (PHINode &phi, Expr lhs, Expr val)
+   *     defines the new value lhs of phi as val. val may be null
+   */
+  template <typename Policy>
+  class SmallSymExecCore : public SmallStepSymExec
+  {
+  protected:
+    Pass &m_pass;
+    TrackLevel m_trackLvl;
+
+    const DataLayout *m_td;
+    const CanFail *m_canFail;
+
+  public:
+    SmallSymExecCore (ExprFactory &efac, Pass &pass, TrackLevel trackLvl) :
+      SmallStepSymExec (efac), m_pass (pass), m_trackLvl (trackLvl)
+    {
+      m_td = &pass.getAnalysis<DataLayoutPass> ().getDataLayout ();
+      m_canFail = pass.getAnalysisIfAvailable<CanFail> ();
+    }
+    SmallSymExecCore (const SmallSymExecCore &o) :
+      SmallStepSymExec (o), m_pass (o.m_pass), m_trackLvl (o.m_trackLvl),
+      m_td (o.m_td), m_canFail (o.m_canFail) {}
+
+    Expr errorFlag (const BasicBlock &BB) override;
+
+    virtual void execEdg (SymStore &s, const BasicBlock &src,
+                          const BasicBlock &dst, ExprVector &side);
+
+    virtual void execBr (SymStore &s, const BasicBlock &src, const BasicBlock &dst,
+                         ExprVector &side, Expr act);
+
+    virtual Expr symb (const Value &v);
+    virtual const Value &conc (Expr v);
+    virtual bool isTracked (const Value &v);
+    virtual Expr lookup (SymStore &s, const Value &v);
+
+    /// -- function calls: summaries, assumptions and shadow memory
+    template <typename Visitor>
+    void execCallSite (Visitor &v, CallSite CS);
+    /// -- all phi-nodes of bb on the edge from pred, atomically
+    template <typename Visitor>
+    void execPhis (Visitor &v, BasicBlock &bb, const BasicBlock &pred);
+
+    Expr ptrArith (SymStore &s, const Value& base,
+                   SmallVectorImpl<const Value*> &ps,
+                   SmallVectorImpl<const Type *> &ts);
+    unsigned storageSize (const llvm::Type *t);
+    unsigned fieldOff (const StructType *t, unsigned field);
+  };
+
+  template <typename Policy>
+  Expr SmallSymExecCore<Policy>::errorFlag (const BasicBlock &BB)
+  {
+    // -- if BB belongs to a function that cannot fail, errorFlag is always false
+    if (m_canFail && !m_canFail->canFail (BB.getParent ())) return falseE;
+    return this->SmallStepSymExec::errorFlag (BB);
+  }
+
+  template <typename Policy> template <typename Visitor>
+  void SmallSymExecCore<Policy>::execCallSite (Visitor &v, CallSite CS)
+  {
+    assert (CS.isCall ());
+    const Function *f = CS.getCalledFunction ();
+
+    Instruction &I = *CS.getInstruction ();
+    BasicBlock &BB = *I.getParent ();
+    SymStore &s = v.m_s;
+    ExprVector &fparams = v.m_fparams;
+
+    // -- unknown/indirect function call
+    if (!f)
+    {
+      // XXX Use DSA and/or Devirt to handle better
+      assert (fparams.size () == 3);
+      v.visitInstruction (I);
+      return;
+    }
+
+    const Function &F = *f;
+    const Function &PF = *I.getParent ()->getParent ();
+
+    // skip intrinsic functions
+    if (F.isIntrinsic ()) { assert (fparams.size () == 3); return;}
+
+    intrinsic::Kind kind = intrinsicKind (F);
+
+    if (kind == intrinsic::VERIFIER_ASSUME ||
+        kind == intrinsic::VERIFIER_ASSUME_NOT)
+    {
+      Expr c = v.lookup (*CS.getArgument (0));
+      if (kind == intrinsic::VERIFIER_ASSUME_NOT) c = boolop::lneg (c);
+
+      assert (fparams.size () == 3);
+      // -- assumption is only active when error flag is false
+      v.m_side.push_back (Policy::guard (v.activeLit (),
+                                         boolop::lor (s.read (errorFlag (BB)), c)));
+    }
+    else if (v.execIntrinsic (CS, kind)) assert (fparams.size () == 3);
+    else if (hasFunctionInfo (F))
+    {
+      const FunctionInfo &fi = getFunctionInfo (F);
+
+      // enabled
+      fparams [0] = v.activeLit (); // activation literal
+      // error flag in
+      fparams [1] = (s.read (errorFlag (BB)));
+      // error flag out
+      fparams [2] = (s.havoc (errorFlag (BB)));
+      for (const Argument *arg : fi.args)
+        fparams.push_back (s.read (symb (*CS.getArgument (arg->getArgNo ()))));
+      for (const GlobalVariable *gv : fi.globals)
+        fparams.push_back (s.read (symb (*gv)));
+
+      if (fi.ret) fparams.push_back (s.havoc (symb (I)));
+
+      LOG ("arg_error",
+           if (fparams.size () != bind::domainSz (fi.sumPred))
+           {
+             errs () << "Call instruction: " << I << "\n";
+             errs () << "Caller: " << PF << "\n";
+             errs () << "Callee: " << F << "\n";
+             errs () << "m_fparams.size: " << fparams.size () << "\n";
+             errs () << "Domain size: " << bind::domainSz (fi.sumPred) << "\n";
+             errs () << "m_fparams\n";
+             for (auto r : fparams) errs () << *r << "\n";
+             errs () << "regions: " << fi.regions.size ()
+                     << " args: " << fi.args.size ()
+                     << " globals: " << fi.globals.size ()
+                     << " ret: " << fi.ret << "\n";
+             errs () << "regions\n";
+             for (auto r : fi.regions) errs () << *r << "\n";
+             errs () << "args\n";
+             for (auto r : fi.args) errs () << *r << "\n";
+             errs () << "globals\n";
+             for (auto r : fi.globals) errs () << *r << "\n";
+             if (fi.ret) errs () << "ret: " << *fi.ret << "\n";
+           }
+           );
+
+      assert (fparams.size () == bind::domainSz (fi.sumPred));
+      v.m_side.push_back (bind::fapp (fi.sumPred, fparams));
+
+      fparams.clear ();
+      fparams.push_back (v.falseE);
+      fparams.push_back (v.falseE);
+      fparams.push_back (v.falseE);
+    }
+    else if (intrinsic::isShadowMem (kind) && isTracked (I))
+    {
+      bool inMain = intrinsicKind (PF) == intrinsic::MAIN;
+      switch (kind)
+      {
+      case intrinsic::SHADOW_MEM_INIT:
+        s.havoc (symb(I));
+        break;
+      case intrinsic::SHADOW_MEM_LOAD:
+        v.m_inMem = s.read (symb (*CS.getArgument (1)));
+        v.shadowMemAccess (CS, kind);
+        break;
+      case intrinsic::SHADOW_MEM_STORE:
+        v.m_inMem = s.read (symb (*CS.getArgument (1)));
+        v.m_outMem = s.havoc (symb (I));
+        v.shadowMemAccess (CS, kind);
+        break;
+      case intrinsic::SHADOW_MEM_ARG_REF:
+        fparams.push_back (s.read (symb (*CS.getArgument (1))));
+        break;
+      case intrinsic::SHADOW_MEM_ARG_MOD:
+        fparams.push_back (s.read (symb (*CS.getArgument (1))));
+        fparams.push_back (s.havoc (symb (I)));
+        break;
+      case intrinsic::SHADOW_MEM_ARG_NEW:
+        fparams.push_back (s.havoc (symb (I)));
+        break;
+      case intrinsic::SHADOW_MEM_IN:
+      case intrinsic::SHADOW_MEM_OUT:
+        if (!inMain) s.read (symb (*CS.getArgument (1)));
+        break;
+      case intrinsic::SHADOW_MEM_ARG_INIT:
+        // regions initialized in main are global. We want them to
+        // flow to the arguments
+        /* do nothing */
+        break;
+      default:
+        break;
+      }
+    }
+    else
+    {
+      if (fparams.size () > 3)
+      {
+        fparams.resize (3);
+        // -- modified regions are already havoced
+        if (!isAbstracted (F))
+          errs () << "WARNING: skipping a call to " << F.getName ()
+                  << " (recursive call?)\n";
+      }
+
+      v.visitInstruction (I);
+    }
+  }
+
+  template <typename Policy> template <typename Visitor>
+  void SmallSymExecCore<Policy>::execPhis (Visitor &v, BasicBlock &bb,
+                                           const BasicBlock &pred)
+  {
+    // -- evaluate all phi-nodes atomically. First read all incoming
+    // -- values, then update phi-nodes all together. A phi-node may
+    // -- read another phi-node of the same block
+    ExprVector ops;
+
+    auto curr = bb.begin ();
+    if (!isa<PHINode> (curr)) return;
+
+    for (; PHINode *phi = dyn_cast<PHINode> (curr); ++curr)
+    {
+      // skip phi nodes that are not tracked
+      if (!isTracked (*phi)) continue;
+      const Value &val = *phi->getIncomingValueForBlock (&pred);
+      ops.push_back (v.lookup (val));
+    }
+
+    curr = bb.begin ();
+    for (unsigned i = 0; isa<PHINode> (curr); ++curr)
+    {
+      PHINode &phi = *cast<PHINode> (curr);
+      if (!isTracked (phi)) continue;
+      Expr lhs = v.havoc (phi);
+      v.definePhi (phi, lhs, ops [i++]);
+    }
+  }
+
+  template <typename Policy>
+  Expr SmallSymExecCore<Policy>::ptrArith (SymStore &s,
+                                           const Value &base,
+                                           SmallVectorImpl<const Value*> &ps,
+                                           SmallVectorImpl<const Type*> &ts)
+  {
+    Expr res = lookup (s, base);
+    if (!res) return res;
+
+    for (unsigned i = 0; i < ps.size (); ++i)
+    {
+      if (const StructType *st = dyn_cast<const StructType> (ts [i]))
+      {
+        if (const ConstantInt *ci = dyn_cast<const ConstantInt> (ps [i]))
+        {
+          Expr off = mkTerm<mpz_class> (fieldOff (st, ci->getZExtValue ()), m_efac);
+          res = linear::mkPlus (res, off);
+        }
+        else assert (0);
+      }
+      else if (const SequentialType *seqt = dyn_cast<const SequentialType> (ts [i]))
+      {
+        Expr sz = mkTerm<mpz_class> (storageSize (seqt->getElementType ()), m_efac);
+        res = linear::mkPlus (res, linear::mkMult (lookup (s, *ps[i]), sz));
+      }
+    }
+    return res;
+  }
+
+  template <typename Policy>
+  unsigned SmallSymExecCore<Policy>::storageSize (const llvm::Type *t)
+  {return m_td->getTypeStoreSize (const_cast<Type*> (t));}
+
+  template <typename Policy>
+  unsigned SmallSymExecCore<Policy>::fieldOff (const StructType *t, unsigned field)
+  {
+    return m_td->getStructLayout (const_cast<StructType*>(t))->getElementOffset (field);
+  }
+
+  template <typename Policy>
+  Expr SmallSymExecCore<Policy>::symb (const Value &I)
+  {
+    // -- basic blocks are mapped to Bool constants
+    if (const BasicBlock *bb = dyn_cast<const BasicBlock> (&I))
+      return bind::boolConst
+        (mkTerm<const BasicBlock*> (bb, m_efac));
+
+    // -- constants are mapped to values
+    if (const Constant *cv = dyn_cast<const Constant> (&I))
+    {
+      if (const ConstantInt *c = dyn_cast<const ConstantInt> (&I))
+      {
+        if (c->getType ()->isIntegerTy (1))
+          return c->isOne () ? mk<TRUE> (m_efac) : mk<FALSE> (m_efac);
+        mpz_class k = toMpz (c->getValue ());
+        return mkTerm<mpz_class> (k, m_efac);
+      }
+      else if (cv->isNullValue () || isa<ConstantPointerNull> (&I))
+        return mkTerm<mpz_class> (0, m_efac);
+      else if (const ConstantExpr *ce = dyn_cast<const ConstantExpr> (&I))
+      {
+        // -- if this is a cast, and not into a Boolean, strip it
+        // -- XXX handle Boolean casts if needed
+        if (ce->isCast () &&
+            (ce->getType ()->isIntegerTy () || ce->getType ()->isPointerTy ()) &&
+            ! ce->getType ()->isIntegerTy (1))
+
+        {
+          if (const ConstantInt* val = dyn_cast<const ConstantInt>(ce->getOperand (0)))
+          {
+            mpz_class k = toMpz (val->getValue ());
+            return mkTerm<mpz_class> (k, m_efac);
+          }
+          // -- strip cast
+          else return symb (*ce->getOperand (0));
+        }
+      }
+    }
+
+    // -- everything else is mapped to a constant
+    Expr v = mkTerm<const Value*> (&I, m_efac);
+
+    const Value *scalar = nullptr;
+    if (Policy::shadowMem (I, &scalar))
+    {
+      if (scalar)
+        // -- create a constant with the name v[scalar]
+        return bind::intConst
+          (op::array::select (v, mkTerm<const Value*> (scalar, m_efac)));
+
+      if (m_trackLvl >= MEM)
+      {
+        Expr intTy = sort::intTy (m_efac);
+        Expr ty = sort::arrayTy (intTy, intTy);
+        return bind::mkConst (v, ty);
+      }
+    }
+
+    if (isTracked (I))
+      return I.getType ()->isIntegerTy (1) ?
+        bind::boolConst (v) : bind::intConst (v);
+
+    return Expr(0);
+  }
+
+  template <typename Policy>
+  const Value &SmallSymExecCore<Policy>::conc (Expr v)
+  {
+    assert (isOpX<FAPP> (v));
+    // name of the app
+    Expr u = bind::fname (v);
+    // name of the fdecl
+    u = bind::fname (u);
+    assert (isOpX<VALUE> (v));
+    return *getTerm<const Value*> (v);
+  }
+
+  template <typename Policy>
+  bool SmallSymExecCore<Policy>::isTracked (const Value &v)
+  {
+    const Value* scalar = nullptr;
+
+    // -- shadow values represent memory regions
+    // -- only track them when memory is tracked
+    if (Policy::shadowMem (v, &scalar))
+      return scalar != nullptr || m_trackLvl >= MEM;
+
+    // -- a pointer
+    if (v.getType ()->isPointerTy ())
+    {
+      // -- XXX A hack because shadow.mem generates not well formed
+      // -- bitcode that contains future references. A register that
+      // -- is defined later is used to name a shadow region in the
+      // -- beginning of the function. Perhaps there is a better
+      // -- solution. For now, we just do not track anything that came
+      // -- that way.
+      if (v.hasOneUse ())
+        if (const CallInst *ci = dyn_cast<const CallInst> (*v.user_begin ()))
+          if (const Function *fn = ci->getCalledFunction ())
+            if (intrinsic::isShadowMem (m_intrinsics.kind (*fn))) return false;
+
+      return m_trackLvl >= PTR;
+    }
+
+    // -- always track integer registers
+    return v.getType ()->isIntegerTy ();
+  }
+
+  template <typename Policy>
+  Expr SmallSymExecCore<Policy>::lookup (SymStore &s, const Value &v)
+  {
+    Expr u = symb (v);
+    // if u is defined it is either an fapp or a constant
+    if (u) return bind::isFapp (u) ? s.read (u) : u;
+    return Expr (0);
+  }
+
+  template <typename Policy>
+  void SmallSymExecCore<Policy>::execEdg (SymStore &s, const BasicBlock &src,
+                                          const BasicBlock &dst, ExprVector &side)
+  {
+    Expr trueE = mk<TRUE> (m_efac);
+    exec (s, src, side, trueE);
+    execBr (s, src, dst, side, trueE);
+    execPhi (s, dst, src, side, trueE);
+
+    // an edge into a basic block that does not return includes the block itself
+    const TerminatorInst *term = dst.getTerminator ();
+    if (term && isa<const UnreachableInst> (term)) exec (s, dst, side, trueE);
+  }
+
+  template <typename Policy>
+  void SmallSymExecCore<Policy>::execBr (SymStore &s, const BasicBlock &src,
+                                         const BasicBlock &dst,
+                                         ExprVector &side, Expr act)
+  {
+    // the branch condition
+    if (const BranchInst *br = dyn_cast<const BranchInst> (src.getTerminator ()))
+    {
+      if (br->isConditional ())
+      {
+        const Value &c = *br->getCondition ();
+        if (const ConstantInt *ci = dyn_cast<const ConstantInt> (&c))
+        {
+          if ((ci->isOne () && br->getSuccessor (0) != &dst) ||
+              (ci->isZero () && br->getSuccessor (1) != &dst))
+          {
+            side.clear ();
+            side.push_back (Policy::guard (act, s.read (errorFlag (src))));
+          }
+        }
+        else if (Expr target = lookup (s, c))
+        {
+          Expr cond = br->getSuccessor (0) == &dst ? target : Policy::negate (target);
+          cond = boolop::lor (s.read (errorFlag (src)), cond);
+          side.push_back (Policy::guard (act, cond));
+        }
+      }
+    }
+  }
+}
+
+#endif
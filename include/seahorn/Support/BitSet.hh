@@ -0,0 +1,111 @@
+#ifndef __BIT_SET_HH_
+#define __BIT_SET_HH_
+
+#include "llvm/Support/MathExtras.h"
+
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+
+namespace seahorn
+{
+  /// A fixed-size set of bits for dense dataflow problems.
+  ///
+  /// The storage is aligned to and padded to whole cache lines, so
+  /// the bulk operations below run over full vector registers without
+  /// a scalar tail. They use AVX2 or SSE2 when the compiler targets
+  /// them (e.g., -mavx2) and plain 64-bit words otherwise. All bulk
+  /// operations require sets of the same size.
+  class BitSet
+  {
+    typedef uint64_t Word;
+    enum { WordBits = 64, LineWords = 8 };
+
+    /// allocated memory and its first aligned word
+    Word *m_alloc;
+    Word *m_words;
+    /// number of bits, and number of words including the padding
+    unsigned m_size;
+    unsigned m_nwords;
+
+    void allocate (unsigned sz);
+
+  public:
+    BitSet () : m_alloc (NULL), m_words (NULL), m_size (0), m_nwords (0) {}
+    explicit BitSet (unsigned sz) : m_alloc (NULL), m_words (NULL)
+    { allocate (sz); }
+    BitSet (const BitSet &o);
+    BitSet (BitSet &&o) noexcept :
+      m_alloc (NULL), m_words (NULL), m_size (0), m_nwords (0) { swap (o); }
+    ~BitSet () { delete [] m_alloc; }
+
+    BitSet &operator= (BitSet o) { swap (o); return *this; }
+
+    void swap (BitSet &o)
+    {
+      std::swap (m_alloc, o.m_alloc);
+      std::swap (m_words, o.m_words);
+      std::swap (m_size, o.m_size);
+      std::swap (m_nwords, o.m_nwords);
+    }
+
+    /// number of bits
+    unsigned size () const { return m_size; }
+    /// resizes the set to sz bits, all of them clear
+    void resize (unsigned sz) { BitSet tmp (sz); swap (tmp); }
+    /// clears all bits
+    void clear () { std::fill (m_words, m_words + m_nwords, Word (0)); }
+
+    bool test (unsigned i) const
+    {
+      assert (i < m_size);
+      return (m_words [i / WordBits] >> (i % WordBits)) & 1;
+    }
+    void set (unsigned i)
+    {
+      assert (i < m_size);
+      m_words [i / WordBits] |= Word (1) << (i % WordBits);
+    }
+    void reset (unsigned i)
+    {
+      assert (i < m_size);
+      m_words [i / WordBits] &= ~(Word (1) << (i % WordBits));
+    }
+
+    /// this |= o. Returns true if a bit was added
+    bool unionWith (const BitSet &o);
+    /// this |= o & ~mask. Returns true if a bit was added
+    bool unionWithout (const BitSet &o, const BitSet &mask);
+    /// this &= ~o
+    void subtract (const BitSet &o);
+    /// true if some bit is set
+    bool any () const;
+    /// number of bits that are set
+    unsigned count () const;
+
+    bool operator== (const BitSet &o) const
+    { return m_size == o.m_size && std::equal (m_words, m_words + m_nwords, o.m_words); }
+    bool operator!= (const BitSet &o) const { return !(*this == o); }
+
+    /// index of the first set bit, or -1 if there is none
+    int find_first () const { return find_from (0); }
+    /// index of the first set bit after prev, or -1 if there is none
+    int find_next (int prev) const { return find_from (prev + 1); }
+
+  private:
+    int find_from (unsigned i) const
+    {
+      if (i >= m_size) return -1;
+      unsigned w = i / WordBits;
+      Word bits = m_words [w] & (~Word (0) << (i % WordBits));
+      while (bits == 0)
+      {
+        if (++w == m_nwords) return -1;
+        bits = m_words [w];
+      }
+      return w * WordBits + llvm::countTrailingZeros (bits);
+    }
+  };
+}
+
+#endif
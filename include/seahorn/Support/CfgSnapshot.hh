@@ -0,0 +1,71 @@
+#ifndef __CFG_SNAPSHOT_HH_
+#define __CFG_SNAPSHOT_HH_
+
+#include "llvm/IR/Function.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/ArrayRef.h"
+
+#include <vector>
+
+namespace seahorn
+{
+  using namespace llvm;
+
+  /// A compact copy of the CFG of a function.
+  ///
+  /// The blocks reachable from the entry are numbered in reverse
+  /// postorder with the back-edges ignored (i.e., the reverse of
+  /// RevTopoSort), so every edge that is not a back-edge goes from a
+  /// smaller to a larger number. Successors and predecessors are kept
+  /// in CSR form, in the order of the LLVM iterators and with the same
+  /// duplicates. Predecessors that are not reachable are left out.
+  class CfgSnapshot
+  {
+    std::vector<const BasicBlock*> m_blocks;
+    DenseMap<const BasicBlock*, unsigned> m_num;
+
+    /// successors of block i are m_succ [m_succOff [i] .. m_succOff [i+1])
+    std::vector<unsigned> m_succOff;
+    std::vector<unsigned> m_succ;
+    /// predecessors, same layout
+    std::vector<unsigned> m_predOff;
+    std::vector<unsigned> m_pred;
+
+  public:
+    CfgSnapshot () {}
+    explicit CfgSnapshot (const Function &F) { build (F); }
+
+    void build (const Function &F);
+    void clear ();
+
+    /// number of reachable blocks
+    unsigned size () const { return m_blocks.size (); }
+    const BasicBlock *block (unsigned i) const { return m_blocks [i]; }
+    /// blocks in topological order
+    const std::vector<const BasicBlock*> &blocks () const { return m_blocks; }
+
+    bool contains (const BasicBlock &bb) const { return m_num.count (&bb) > 0; }
+    unsigned number (const BasicBlock &bb) const
+    {
+      auto it = m_num.find (&bb);
+      assert (it != m_num.end ());
+      return it->second;
+    }
+
+    ArrayRef<unsigned> succs (unsigned i) const
+    {
+      return ArrayRef<unsigned> (m_succ.data () + m_succOff [i],
+                                 m_succOff [i + 1] - m_succOff [i]);
+    }
+    ArrayRef<unsigned> preds (unsigned i) const
+    {
+      return ArrayRef<unsigned> (m_pred.data () + m_predOff [i],
+                                 m_predOff [i + 1] - m_predOff [i]);
+    }
+
+    /// true if (src, dst) is a back-edge
+    bool isBackEdge (unsigned src, unsigned dst) const { return dst <= src; }
+  };
+}
+
+#endif
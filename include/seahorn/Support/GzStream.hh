@@ -0,0 +1,42 @@
+#ifndef __GZ_STREAM_HH_
+#define __GZ_STREAM_HH_
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <memory>
+
+struct z_stream_s;
+
+namespace seahorn
+{
+  /// True if the file name asks for gzip compressed output
+  inline bool isGzFileName (llvm::StringRef fname)
+  { return fname.endswith (".gz"); }
+
+  /**
+   * A raw_ostream that gzip-compresses everything written to it and
+   * forwards the compressed bytes to another stream. Compression is
+   * streaming: memory use is independent of the size of the output.
+   * The gzip trailer is written when the stream is destroyed.
+   */
+  class raw_gz_ostream : public llvm::raw_ostream
+  {
+    llvm::raw_ostream &m_out;
+    std::unique_ptr<z_stream_s> m_zs;
+    /// -- number of uncompressed bytes written so far
+    uint64_t m_pos;
+
+    void write_impl (const char *ptr, size_t size) override;
+    uint64_t current_pos () const override { return m_pos; }
+
+    void deflateTo (int flush);
+
+  public:
+    /// level is the zlib compression level (1 fastest, 9 best)
+    raw_gz_ostream (llvm::raw_ostream &out, int level = 6);
+    ~raw_gz_ostream ();
+  };
+}
+
+#endif
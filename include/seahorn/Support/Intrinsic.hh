@@ -0,0 +1,84 @@
+#ifndef __INTRINSIC_HH_
+#define __INTRINSIC_HH_
+
+#include "llvm/IR/Function.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringSwitch.h"
+
+namespace seahorn
+{
+  using namespace llvm;
+
+  namespace intrinsic
+  {
+    /// Functions with a special meaning to symbolic execution
+    enum Kind
+    {
+      /// any other function
+      NONE,
+      /// the entry point
+      MAIN,
+      VERIFIER_ASSUME,
+      VERIFIER_ASSUME_NOT,
+      CALLOC,
+      /// initial contents of globals, see LowerGvInitializers
+      GV_INIT,
+      SHADOW_MEM_INIT,
+      SHADOW_MEM_LOAD,
+      SHADOW_MEM_STORE,
+      SHADOW_MEM_ARG_REF,
+      SHADOW_MEM_ARG_MOD,
+      SHADOW_MEM_ARG_NEW,
+      SHADOW_MEM_IN,
+      SHADOW_MEM_OUT,
+      SHADOW_MEM_ARG_INIT,
+      /// any other shadow.mem function
+      SHADOW_MEM
+    };
+
+    inline Kind classify (const Function &F)
+    {
+      StringRef name = F.getName ();
+      if (!name.startswith ("shadow.mem"))
+        return StringSwitch<Kind> (name)
+          .Case ("main", MAIN)
+          .Case ("verifier.assume", VERIFIER_ASSUME)
+          .Case ("verifier.assume.not", VERIFIER_ASSUME_NOT)
+          .Case ("calloc", CALLOC)
+          .Case ("verifier.gv.init", GV_INIT)
+          .Default (NONE);
+
+      return StringSwitch<Kind> (name)
+        .Case ("shadow.mem.init", SHADOW_MEM_INIT)
+        .Case ("shadow.mem.load", SHADOW_MEM_LOAD)
+        .Case ("shadow.mem.store", SHADOW_MEM_STORE)
+        .Case ("shadow.mem.arg.ref", SHADOW_MEM_ARG_REF)
+        .Case ("shadow.mem.arg.mod", SHADOW_MEM_ARG_MOD)
+        .Case ("shadow.mem.arg.new", SHADOW_MEM_ARG_NEW)
+        .Case ("shadow.mem.in", SHADOW_MEM_IN)
+        .Case ("shadow.mem.out", SHADOW_MEM_OUT)
+        .Case ("shadow.mem.arg.init", SHADOW_MEM_ARG_INIT)
+        .Default (SHADOW_MEM);
+    }
+
+    inline bool isShadowMem (Kind k)
+    { return k >= SHADOW_MEM_INIT && k <= SHADOW_MEM; }
+  }
+
+  /// Classifies every function once. Lookups afterwards are a
+  /// pointer hash instead of string compares
+  class IntrinsicCache
+  {
+    DenseMap<const Function*, intrinsic::Kind> m_kinds;
+
+  public:
+    intrinsic::Kind kind (const Function &F)
+    {
+      auto it = m_kinds.find (&F);
+      if (it != m_kinds.end ()) return it->second;
+      return m_kinds [&F] = intrinsic::classify (F);
+    }
+  };
+}
+
+#endif
@@ -2,10 +2,12 @@
 #define __SYM_EXEC__HH_
 
 #include "llvm/IR/InstVisitor.h"
+#include "llvm/ADT/DenseSet.h"
 #include "ufo/Expr.hpp"
 #include "ufo/ExprLlvm.hpp"
 #include "seahorn/SymStore.hh"
 #include "seahorn/Analysis/CutPointGraph.hh"
+#include "seahorn/Support/Intrinsic.hh"
 
 #include "avy/AvyDebug.h"
 
@@ -54,6 +56,10 @@ namespace seahorn
   protected:
     ExprFactory &m_efac;
     FuncInfoMap m_fmap;
+    IntrinsicCache m_intrinsics;
+    /// functions whose calls are abstracted by havoc of their
+    /// modified regions instead of a summary
+    DenseSet<const Function*> m_abstracted;
     
     Expr trueE;
     Expr falseE;
@@ -70,12 +76,18 @@ namespace seahorn
     SmallStepSymExec (const SmallStepSymExec &o) : 
       m_efac (o.m_efac), 
       m_fmap (o.m_fmap),
+      m_intrinsics (o.m_intrinsics),
+      m_abstracted (o.m_abstracted),
       m_errorFlag (o.m_errorFlag) {}
     
     virtual ~SmallStepSymExec () {}
     
     ExprFactory& getExprFactory () {return m_efac;}
     
+    /// kind of a function with a special meaning to symbolic execution
+    intrinsic::Kind intrinsicKind (const Function &F)
+    {return m_intrinsics.kind (F);}
+    
     /// Executes all instructions in the basic block. Modifies the
     /// store s and returns a side condition. The side-constraints are
     /// optionally conditioned on the activation literal
@@ -116,6 +128,11 @@ namespace seahorn
     virtual bool hasFunctionInfo (const Function &F) const
     {return m_fmap.count (&F) > 0;}
     
+    /// calls to F are havoc of the regions F modifies
+    void abstractFunction (const Function &F) {m_abstracted.insert (&F);}
+    bool isAbstracted (const Function &F) const
+    {return m_abstracted.count (&F) > 0;}
+    
     virtual Expr errorFlag (const BasicBlock &BB) {return m_errorFlag;}
     
   };
@@ -48,6 +48,7 @@ namespace seahorn
     
     AllocaInst* allocaForNode (const DSNode *n);
     unsigned getId (const DSNode *n);
+    void mergeGvInits (Function &F, DSGraph *dsg, DSGraph *gDsg);
     
     
   public:
@@ -1,8 +1,13 @@
 #ifndef _LOWER_GV_INITIALIZERS__HH__
 #define _LOWER_GV_INITIALIZERS__HH__
 
-/** Pass to lower scalar initializers to global variables into
-    explicit initialization code */
+/** Pass to lower initializers of global variables into explicit
+    initialization code. Integer scalars become stores. Every other
+    non-constant global becomes a call verifier.gv.init(@g) at the
+    entry of main. ShadowMemDsa merges the calls of one memory region
+    and the Ufo encoding defines the region from the initializers in
+    a single constraint. Unused globals are skipped, and a module is
+    only lowered once */
 
 #include "llvm/Pass.h"
 #include "llvm/IR/Module.h"
@@ -25,7 +30,6 @@ namespace seahorn
       AU.setPreservesAll ();
       AU.addRequired<llvm::DataLayoutPass>();
     }
-    
   };
 }
 
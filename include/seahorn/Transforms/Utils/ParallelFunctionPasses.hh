@@ -0,0 +1,34 @@
+#ifndef _PARALLEL_FUNCTION_PASSES__HH_
+#define _PARALLEL_FUNCTION_PASSES__HH_
+
+#include "llvm/IR/Module.h"
+#include "llvm/PassManager.h"
+
+#include <functional>
+
+namespace seahorn
+{
+  using namespace llvm;
+
+  /**
+   * Runs a pipeline of function-level passes on the definitions of M
+   * using up to jobs threads.
+   *
+   * The definitions are split into jobs parts of about the same
+   * size. Every worker reads its own copy of M into a private
+   * LLVMContext, drops the bodies of the functions outside of its
+   * part, and runs the passes added by addPasses. The parts are then
+   * linked back into M.
+   *
+   * The passes must only change the functions they run on. New
+   * declarations (e.g., verifier.nondet functions) are allowed.
+   *
+   * Falls back to running the passes on M directly if the module
+   * cannot be split (aliases or comdats) or there is nothing to gain.
+   * Returns false if the parts could not be linked back.
+   */
+  bool runFunctionPassesInParallel (Module &M, unsigned jobs,
+                                    std::function<void (PassManager&)> addPasses);
+}
+
+#endif /* _PARALLEL_FUNCTION_PASSES__HH_ */
@@ -1,34 +1,21 @@
 #ifndef __UFO_SYM_EXEC_HH_
 #define __UFO_SYM_EXEC_HH_
 
-#include "llvm/Pass.h"
-#include "llvm/IR/DataLayout.h"
-#include "seahorn/SymExec.hh"
-#include "seahorn/Analysis/CanFail.hh"
+#include "seahorn/SmallSymExecCore.hh"
 
 namespace seahorn
 {
   /// Small step symbolic execution for integers based on UFO semantics
-  class UfoSmallSymExec : public SmallStepSymExec
+  class UfoSmallSymExec : public SmallSymExecCore<UfoSmallSymExec>
   { 
-    Pass &m_pass;
-    TrackLevel m_trackLvl;
-   
-    const DataLayout *m_td;
-    const CanFail *m_canFail;
-    
+    /// -- definitions that can be emitted unguarded
+    DenseMap<const Instruction*, bool> m_globalDefs;
     
   public:
     UfoSmallSymExec (ExprFactory &efac, Pass &pass, TrackLevel trackLvl = MEM) : 
-      SmallStepSymExec (efac), m_pass (pass), m_trackLvl (trackLvl)
-    {
-      m_td = &pass.getAnalysis<DataLayoutPass> ().getDataLayout ();
-      m_canFail = pass.getAnalysisIfAvailable<CanFail> ();
-    }
+      SmallSymExecCore (efac, pass, trackLvl) {}
     UfoSmallSymExec (const UfoSmallSymExec& o) : 
-      SmallStepSymExec (o), m_pass (o.m_pass), m_trackLvl (o.m_trackLvl) {}
-    
-    Expr errorFlag (const BasicBlock &BB) override;
+      SmallSymExecCore (o), m_globalDefs (o.m_globalDefs) {}
     
     virtual void exec (SymStore &s, const BasicBlock &bb, 
                        ExprVector &side, Expr act);
@@ -39,22 +26,15 @@ namespace seahorn
     virtual void execPhi (SymStore &s, const BasicBlock &bb, 
                           const BasicBlock &from, ExprVector &side, Expr act);
     
-    virtual void execEdg (SymStore &s, const BasicBlock &src,
-                          const BasicBlock &dst, ExprVector &side);
-    
-    virtual void execBr (SymStore &s, const BasicBlock &src, const BasicBlock &dst,
-                         ExprVector &side, Expr act);
+    /// true if the constraint defining I can be emitted without an
+    /// activation literal: it is satisfiable for any operands, I is
+    /// not a phi-node, and I is only used inside its own block
+    bool isGlobalDef (const Instruction &I);
     
-    virtual Expr symb (const Value &v);
-    virtual const Value &conc (Expr v);
-    virtual bool isTracked (const Value &v);
-    virtual Expr lookup (SymStore &s, const Value &v);
-    
-    Expr ptrArith (SymStore &s, const Value& base, 
-                   SmallVectorImpl<const Value*> &ps,
-                   SmallVectorImpl<const Type *> &ts);
-    unsigned storageSize (const llvm::Type *t);
-    unsigned fieldOff (const StructType *t, unsigned field);
+    /// -- policy of SmallSymExecCore
+    static bool shadowMem (const Value &v, const Value **scalar);
+    static Expr negate (Expr e) { return mk<NEG> (e); }
+    static Expr guard (Expr act, Expr e) { return boolop::limp (act, e); }
   }; 
   
 
@@ -64,7 +44,16 @@ namespace seahorn
     Expr trueE;
     
     void execEdgBb (SymStore &s, const CpEdge &edge, 
-                    const BasicBlock &bb, ExprVector &side, bool last = false);
+                    const BasicBlock &bb, ExprVector &side, 
+                    ExprVector &merged, bool last = false);
+    
+    /// phi-nodes of bb as if-then-else over the incoming edges,
+    /// written directly into the store. Keys whose value is not a
+    /// variable are added to merged
+    void mergePhis (SymStore &s, const BasicBlock &bb,
+                    ArrayRef<const BasicBlock*> preds,
+                    const ExprVector &edges, ExprVector &side, 
+                    ExprVector &merged);
     
   public:
     UfoLargeSymExec (SmallStepSymExec &sem)
@@ -72,7 +61,9 @@ namespace seahorn
     
     virtual void execCpEdg (SymStore &s, const CpEdge &edge, ExprVector &side);
     
-    
+    /// conjunction of the side constraints of an edge. The Boolean
+    /// skeleton is compressed by an AIG if enabled
+    Expr conjoin (const ExprVector &side);
   };  
 }
 
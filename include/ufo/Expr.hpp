@@ -2717,6 +2717,90 @@ namespace expr
     return dagVisit (rv, exp);
   }
 
+  /**
+   * Simultaneous replacement applied to many expressions. The map is
+   * compiled once into a hash table keyed by node and all
+   * applications share one memo table, so a sub-expression common to
+   * several expressions is rewritten only once. Changing the map
+   * clears the memo table.
+   */
+  class Substitution : boost::noncopyable
+  {
+    typedef boost::unordered_map<ENode*,Expr> map_type;
+
+    /** keeps the keys of the map alive */
+    ExprVector m_keys;
+    map_type m_map;
+    /** null unless the result is simplified */
+    boost::shared_ptr<op::boolop::TrivialSimplifier> m_simp;
+    DagVisitCache m_memo;
+
+    struct Visitor
+    {
+      const Substitution &s;
+      Visitor (const Substitution &sub) : s (sub) {}
+      VisitAction operator() (Expr exp) const
+      {
+	map_type::const_iterator it = s.m_map.find (&*exp);
+	if (it != s.m_map.end ()) return VisitAction::changeTo (it->second);
+	if (s.m_simp) return VisitAction::changeDoKidsRewrite (exp, s.m_simp);
+	return VisitAction::doKids ();
+      }
+    };
+
+  public:
+    Substitution (ExprFactory &efac, bool simplify = false)
+    { if (simplify) m_simp.reset (new op::boolop::TrivialSimplifier (efac)); }
+
+    template <typename M>
+    Substitution (ExprFactory &efac, const M &map, bool simplify = false)
+    {
+      if (simplify) m_simp.reset (new op::boolop::TrivialSimplifier (efac));
+      for (typename M::const_iterator it = map.begin (), end = map.end (); 
+	   it != end; ++it)
+	add (it->first, it->second);
+    }
+    
+    /** replaces every element of from by the matching element of to */
+    template <typename Range1, typename Range2>
+    Substitution (ExprFactory &efac, const Range1 &from, const Range2 &to, 
+		  bool simplify = false)
+    {
+      if (simplify) m_simp.reset (new op::boolop::TrivialSimplifier (efac));
+      typename boost::range_const_iterator<Range2>::type t = boost::begin (to);
+      for (typename boost::range_const_iterator<Range1>::type 
+	     f = boost::begin (from), end = boost::end (from); f != end; ++f, ++t)
+	{
+	  assert (t != boost::end (to));
+	  add (*f, *t);
+	}
+    }
+
+    ~Substitution () { clearDagVisitCache (m_memo); }
+
+    /** adds (or changes) the replacement of from */
+    void add (Expr from, Expr to)
+    {
+      if (!m_memo.empty ()) clearDagVisitCache (m_memo);
+      std::pair<map_type::iterator,bool> res = 
+	m_map.insert (map_type::value_type (&*from, to));
+      if (res.second) m_keys.push_back (from);
+      else res.first->second = to;
+    }
+
+    bool empty () const { return m_map.empty (); }
+
+    Expr operator() (Expr exp)
+    {
+      Visitor v (*this);
+      return visit (v, exp, m_memo);
+    }
+
+    /** applies the substitution to every element of a vector */
+    void apply (ExprVector &vec)
+    { for (Expr &e : vec) e = (*this) (e); }
+  };
+
   
   /** Returns true if e1 contains e2 as a sub-expression */
   inline bool contains (Expr e1, Expr e2)
@@ -2892,6 +2976,147 @@ namespace expr
     
     
   };
+
+  /** 
+   * Fixed size cache with CLOCK (second chance) eviction over a flat
+   * array of slots. Keys are not referenced. Instead, the cache is
+   * registered with the factory and an entry is erased when its key
+   * dies. The cache must not outlive the factory.
+   */
+  template <typename T>
+  class ExprClockCache : boost::noncopyable
+  {
+    struct Slot
+    {
+      ENode *key;
+      T value;
+      bool used;
+      Slot () : key (NULL), used (false) {}
+    };
+    
+    ExprFactory &efac;
+    std::vector<Slot> slots;
+    boost::unordered_map<ENode*, size_t> index;
+    /** the clock hand */
+    size_t hand;
+    
+    size_t m_hits;
+    size_t m_misses;
+    size_t m_evictions;
+    
+    /** next slot to reuse: a free slot or the first slot that has
+        not been used since the hand last passed it */
+    size_t victim ()
+    {
+      while (true)
+	{
+	  size_t i = hand;
+	  hand = (hand + 1) % slots.size ();
+	  Slot &s = slots [i];
+	  if (s.key == NULL || !s.used) return i;
+	  s.used = false;
+	}
+    }
+    
+  public:
+    ExprClockCache (ExprFactory &f, size_t capacity) : 
+      efac (f), slots (std::max (capacity, size_t (1))), hand (0), 
+      m_hits (0), m_misses (0), m_evictions (0) 
+    { efac.registerCache (*this); }
+    
+    ~ExprClockCache () 
+    { 
+      efac.unregisterCache (*this); 
+      clear ();
+    }
+    
+    /** returns the value cached for e, or NULL. The pointer is only
+	valid until the next insertion */
+    const T *find (Expr e)
+    {
+      typename boost::unordered_map<ENode*, size_t>::const_iterator it = 
+	index.find (&*e);
+      if (it == index.end ()) 
+	{
+	  ++m_misses;
+	  return NULL;
+	}
+      ++m_hits;
+      Slot &s = slots [it->second];
+      s.used = true;
+      return &s.value;
+    }
+    
+    void insert (Expr e, const T &v)
+    {
+      ENode *n = &*e;
+      // -- the old value is released last since releasing it might
+      // -- kill other keys of this cache
+      T old;
+      
+      typename boost::unordered_map<ENode*, size_t>::iterator it = 
+	index.find (n);
+      if (it != index.end ())
+	{
+	  Slot &s = slots [it->second];
+	  std::swap (old, s.value);
+	  s.value = v;
+	  s.used = true;
+	  return;
+	}
+      
+      size_t i = victim ();
+      Slot &s = slots [i];
+      if (s.key != NULL)
+	{
+	  index.erase (s.key);
+	  ++m_evictions;
+	}
+      std::swap (old, s.value);
+      s.key = n;
+      s.value = v;
+      s.used = false;
+      index [n] = i;
+    }
+    
+    /** called by the factory when val dies */
+    void erase (ENode *val)
+    {
+      typename boost::unordered_map<ENode*, size_t>::iterator it = 
+	index.find (val);
+      if (it == index.end ()) return;
+      
+      Slot &s = slots [it->second];
+      index.erase (it);
+      T old;
+      std::swap (old, s.value);
+      s.key = NULL;
+      s.used = false;
+    }
+    
+    void clear ()
+    {
+      std::vector<T> old;
+      old.reserve (index.size ());
+      for (Slot &s : slots)
+	if (s.key != NULL)
+	  {
+	    old.push_back (T ());
+	    std::swap (old.back (), s.value);
+	    s.key = NULL;
+	    s.used = false;
+	  }
+      index.clear ();
+      hand = 0;
+    }
+    
+    size_t size () const { return index.size (); }
+    size_t capacity () const { return slots.size (); }
+    
+    size_t hits () const { return m_hits; }
+    size_t misses () const { return m_misses; }
+    size_t evictions () const { return m_evictions; }
+  };
 }
 
 namespace expr
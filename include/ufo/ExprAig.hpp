@@ -2,6 +2,8 @@
 #define _EXPR_AIG__HPP_
 #include "ufo/Expr.hpp"
 
+#include <boost/functional/hash.hpp>
+
 /** a basic simplifier */
 
 namespace expr
@@ -10,15 +12,227 @@ namespace expr
   {
     namespace boolop
     {
+      /**
+       * And-Inverter Graph over the Boolean structure of an
+       * expression. Every sub-expression that is not a Boolean
+       * connective is an input. A literal is 2*node+sign, node 0 is
+       * the constant false.
+       *
+       * AND gates are structurally hashed and simplified with the
+       * one- and two-level rules of Brummayer and Biere (local
+       * two-level AIG rewriting), which subsume constant
+       * propagation.
+       */
+      class Aig
+      {
+        typedef unsigned Lit;
+        typedef std::pair<Lit,Lit> Gate;
+
+        ExprFactory &m_efac;
+        /// -- fanins of every node. Inputs and the constant have none
+        std::vector<Gate> m_nodes;
+        /// -- input expression of every input node
+        std::vector<Expr> m_inputs;
+        boost::unordered_map<Gate, Lit, boost::hash<Gate> > m_hash;
+        std::map<Expr,Lit> m_toAig;
+        std::map<Lit,Expr> m_toExpr;
+
+        static Lit neg (Lit l) { return l ^ 1; }
+        static bool sign (Lit l) { return l & 1; }
+        static unsigned node (Lit l) { return l >> 1; }
+
+        bool isAnd (Lit l) const { return m_nodes [node (l)].first != 0; }
+        Lit left (Lit l) const { return m_nodes [node (l)].first; }
+        Lit right (Lit l) const { return m_nodes [node (l)].second; }
+
+        Lit mkNode (Gate g, Expr input)
+        {
+          m_nodes.push_back (g);
+          m_inputs.push_back (input);
+          return (m_nodes.size () - 1) << 1;
+        }
+
+      public:
+        enum { FALSE_LIT = 0, TRUE_LIT = 1 };
+
+        Aig (ExprFactory &efac) : m_efac (efac)
+        { mkNode (Gate (0, 0), mk<FALSE> (efac)); }
+
+        Lit mkInput (Expr e)
+        {
+          auto it = m_toAig.find (e);
+          if (it != m_toAig.end ()) return it->second;
+          return m_toAig [e] = mkNode (Gate (0, 0), e);
+        }
+
+        Lit mkAnd (Lit a, Lit b)
+        {
+          if (a > b) std::swap (a, b);
+
+          // -- constants, idempotence and contradiction
+          if (a == FALSE_LIT) return FALSE_LIT;
+          if (a == TRUE_LIT) return b;
+          if (a == b) return a;
+          if (a == neg (b)) return FALSE_LIT;
+
+          for (unsigned i = 0; i < 2; ++i)
+          {
+            Lit x = i == 0 ? a : b;
+            Lit y = i == 0 ? b : a;
+            if (!isAnd (x)) continue;
+            Lit l = left (x), r = right (x);
+
+            if (!sign (x))
+            {
+              // -- (l & r) & y
+              if (y == neg (l) || y == neg (r)) return FALSE_LIT;
+              if (y == l || y == r) return x;
+              if (isAnd (y) && !sign (y))
+              {
+                Lit u = left (y), v = right (y);
+                if (u == neg (l) || u == neg (r) ||
+                    v == neg (l) || v == neg (r)) return FALSE_LIT;
+              }
+            }
+            else
+            {
+              // -- !(l & r) & y
+              if (y == neg (l) || y == neg (r)) return y;
+              if (y == l) return mkAnd (y, neg (r));
+              if (y == r) return mkAnd (y, neg (l));
+              if (isAnd (y) && !sign (y))
+              {
+                Lit u = left (y), v = right (y);
+                // -- y implies !(l & r)
+                if (u == neg (l) || u == neg (r) ||
+                    v == neg (l) || v == neg (r)) return y;
+                // -- y implies (l & r)
+                if ((u == l && v == r) || (u == r && v == l)) return FALSE_LIT;
+              }
+            }
+          }
+
+          Gate g (a, b);
+          auto it = m_hash.find (g);
+          if (it != m_hash.end ()) return it->second;
+          return m_hash [g] = mkNode (g, Expr ());
+        }
+
+        Lit mkOr (Lit a, Lit b) { return neg (mkAnd (neg (a), neg (b))); }
+
+        Lit mkIte (Lit c, Lit t, Lit e)
+        { return mkOr (mkAnd (c, t), mkAnd (neg (c), e)); }
+
+        Lit mkXor (Lit a, Lit b)
+        { return mkOr (mkAnd (a, neg (b)), mkAnd (neg (a), b)); }
+
+        /// literal of the Boolean structure of e
+        Lit toAig (Expr e)
+        {
+          auto it = m_toAig.find (e);
+          if (it != m_toAig.end ()) return it->second;
+
+          Lit res;
+          if (isOpX<TRUE> (e)) res = TRUE_LIT;
+          else if (isOpX<FALSE> (e)) res = FALSE_LIT;
+          else if (isOpX<NEG> (e)) res = neg (toAig (e->left ()));
+          else if (isOpX<AND> (e) || isOpX<OR> (e))
+          {
+            bool isOr = isOpX<OR> (e);
+            res = isOr ? FALSE_LIT : TRUE_LIT;
+            for (auto a = e->args_begin (), end = e->args_end (); a != end; ++a)
+              res = isOr ? mkOr (res, toAig (*a)) : mkAnd (res, toAig (*a));
+          }
+          else if (isOpX<IMPL> (e))
+            res = mkOr (neg (toAig (e->left ())), toAig (e->right ()));
+          else if (isOpX<IFF> (e))
+            res = neg (mkXor (toAig (e->left ()), toAig (e->right ())));
+          else if (isOpX<XOR> (e))
+            res = mkXor (toAig (e->left ()), toAig (e->right ()));
+          else
+            return mkInput (e);
+
+          return m_toAig [e] = res;
+        }
+
+        /// expression of a literal. If gather is true, nested
+        /// conjunctions and disjunctions are flattened
+        Expr toExpr (Lit l, bool gather)
+        {
+          auto it = m_toExpr.find (l);
+          if (it != m_toExpr.end ()) return it->second;
+
+          Expr res;
+          if (l == FALSE_LIT) res = mk<FALSE> (m_efac);
+          else if (l == TRUE_LIT) res = mk<TRUE> (m_efac);
+          else if (!isAnd (l))
+          {
+            res = m_inputs [node (l)];
+            if (sign (l)) res = mk<NEG> (res);
+          }
+          else if (!gather)
+          {
+            res = mk<AND> (toExpr (left (l), gather), toExpr (right (l), gather));
+            if (sign (l)) res = mk<NEG> (res);
+          }
+          else
+          {
+            // -- !(a & b) is written as (!a | !b)
+            ExprVector args;
+            gatherArgs (l & ~1u, sign (l), args);
+            res = sign (l) ? mknary<OR> (args) : mknary<AND> (args);
+          }
+
+          return m_toExpr [l] = res;
+        }
+
+        /// number of gates and inputs in the cone of l
+        unsigned size (Lit l)
+        {
+          std::set<unsigned> seen;
+          std::vector<Lit> todo (1, l);
+          while (!todo.empty ())
+          {
+            Lit n = todo.back ();
+            todo.pop_back ();
+            if (node (n) == 0 || !seen.insert (node (n)).second) continue;
+            if (!isAnd (n)) continue;
+            todo.push_back (left (n));
+            todo.push_back (right (n));
+          }
+          return seen.size ();
+        }
+
+      private:
+        /// collects the arguments of a positive AND gate, negated if
+        /// negate is true
+        void gatherArgs (Lit l, bool negate, ExprVector &args)
+        {
+          for (Lit k : {left (l), right (l)})
+          {
+            if (isAnd (k) && !sign (k)) gatherArgs (k, negate, args);
+            else args.push_back (toExpr (negate ? neg (k) : k, true));
+          }
+        }
+      };
+
       /// aig-fy an expression and simplify it
-      Expr aig (Expr e, bool gather = false);
-      
+      inline Expr aig (Expr e, bool gather = false)
+      {
+        Aig g (e->efac ());
+        return g.toExpr (g.toAig (e), gather);
+      }
+
       /// same as aig(e, true)
       inline Expr flat_aig (Expr e) { return aig (e, true); }
 
       /// size as number of gates + number of inputs
-      unsigned aigSize (Expr e);
-    }  
+      inline unsigned aigSize (Expr e)
+      {
+        Aig g (e->efac ());
+        return g.size (g.toAig (e));
+      }
+    }
   }
 }
 
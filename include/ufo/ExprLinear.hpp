@@ -0,0 +1,227 @@
+#ifndef _EXPR_LINEAR__HPP_
+#define _EXPR_LINEAR__HPP_
+#include "ufo/Expr.hpp"
+
+#include <type_traits>
+
+/** smart constructors for linear integer arithmetic */
+
+namespace expr
+{
+  namespace op
+  {
+    namespace linear
+    {
+      /**
+       * A linear term: a sum of monomials (coefficient * atom) and a
+       * constant. An atom is any term that is not linear structure
+       * over integer numerals.
+       */
+      struct LinTerm
+      {
+        std::map<Expr,mpz_class> coeffs;
+        mpz_class k;
+
+        LinTerm () : k (0) {}
+
+        void add (Expr e, const mpz_class &c)
+        {
+          if (c == 0) return;
+
+          if (isOpX<MPZ> (e))
+          {
+            k += c * getTerm<mpz_class> (e);
+            return;
+          }
+          if (isOpX<PLUS> (e))
+          {
+            for (auto it = e->args_begin (), end = e->args_end (); it != end; ++it)
+              add (*it, c);
+            return;
+          }
+          if (isOpX<MINUS> (e) && e->arity () > 0)
+          {
+            auto it = e->args_begin ();
+            add (*it, c);
+            for (++it; it != e->args_end (); ++it) add (*it, -c);
+            return;
+          }
+          if (isOpX<UN_MINUS> (e))
+          {
+            add (e->left (), -c);
+            return;
+          }
+          if (isOpX<MULT> (e))
+          {
+            // -- numeral factors scale the only non-numeral factor
+            mpz_class f = c;
+            Expr atom;
+            unsigned atoms = 0;
+            for (auto it = e->args_begin (), end = e->args_end (); it != end; ++it)
+            {
+              if (isOpX<MPZ> (*it)) f *= getTerm<mpz_class> (*it);
+              else { atom = *it; ++atoms; }
+            }
+            if (f == 0) return;
+            if (atoms == 0) { k += f; return; }
+            if (atoms == 1) { add (atom, f); return; }
+          }
+
+          mpz_class &a = coeffs [e];
+          a += c;
+          if (a == 0) coeffs.erase (e);
+        }
+
+        void add (const LinTerm &t, const mpz_class &c)
+        {
+          for (auto &kv : t.coeffs)
+          {
+            mpz_class &a = coeffs [kv.first];
+            a += c * kv.second;
+            if (a == 0) coeffs.erase (kv.first);
+          }
+          k += c * t.k;
+        }
+
+        bool isConst () const { return coeffs.empty (); }
+
+        /// the canonical term: monomials sorted by atom, positive
+        /// ones first, minus the negative ones, constant last
+        Expr toExpr (ExprFactory &efac) const
+        {
+          std::vector<std::pair<Expr,mpz_class> > mons (coeffs.begin (), coeffs.end ());
+          std::sort (mons.begin (), mons.end (),
+                     [] (const std::pair<Expr,mpz_class> &a,
+                         const std::pair<Expr,mpz_class> &b)
+                     { return a.first->getId () < b.first->getId (); });
+
+          ExprVector pos, neg;
+          for (auto &m : mons)
+          {
+            ExprVector &v = m.second > 0 ? pos : neg;
+            mpz_class c = abs (m.second);
+            v.push_back (c == 1 ? m.first :
+                         mk<MULT> (mkTerm<mpz_class> (c, efac), m.first));
+          }
+          if (k > 0 || (k != 0 && pos.empty () && neg.empty ()))
+            pos.push_back (mkTerm<mpz_class> (k, efac));
+          else if (k < 0)
+            neg.push_back (mkTerm<mpz_class> (mpz_class (-k), efac));
+
+          if (pos.empty () && neg.empty ()) return mkTerm<mpz_class> (0, efac);
+
+          Expr p = pos.empty () ? Expr () : mknary<PLUS> (pos.front (), pos);
+          if (neg.empty ()) return p;
+          Expr n = mknary<PLUS> (neg.front (), neg);
+          return p ? mk<MINUS> (p, n) : mk<UN_MINUS> (n);
+        }
+      };
+
+      inline LinTerm linTerm (Expr e)
+      {
+        LinTerm res;
+        res.add (e, 1);
+        return res;
+      }
+
+      inline Expr mkPlus (Expr a, Expr b)
+      {
+        LinTerm t = linTerm (a);
+        t.add (b, 1);
+        return t.toExpr (a->efac ());
+      }
+
+      inline Expr mkMinus (Expr a, Expr b)
+      {
+        LinTerm t = linTerm (a);
+        t.add (b, -1);
+        return t.toExpr (a->efac ());
+      }
+
+      /// product. Non-linear unless one of the factors is a numeral
+      inline Expr mkMult (Expr a, Expr b)
+      {
+        if (isOpX<MPZ> (b)) std::swap (a, b);
+        if (!isOpX<MPZ> (a)) return mk<MULT> (a, b);
+
+        LinTerm t;
+        t.add (b, getTerm<mpz_class> (a));
+        return t.toExpr (a->efac ());
+      }
+
+      /// a - b as a linear term
+      inline LinTerm diff (Expr a, Expr b)
+      {
+        LinTerm t = linTerm (a);
+        t.add (b, -1);
+        return t;
+      }
+
+      /// comparisons fold when the difference of the sides is a
+      /// constant. Otherwise the sides are kept as they are
+      template <typename Op>
+      Expr mkCmp (Expr a, Expr b)
+      {
+        ExprFactory &efac = a->efac ();
+        LinTerm t = diff (a, b);
+        if (!t.isConst ()) return mk<Op> (a, b);
+
+        bool res;
+        if (std::is_same<Op,EQ>::value) res = t.k == 0;
+        else if (std::is_same<Op,NEQ>::value) res = t.k != 0;
+        else if (std::is_same<Op,LT>::value) res = t.k < 0;
+        else if (std::is_same<Op,LEQ>::value) res = t.k <= 0;
+        else if (std::is_same<Op,GT>::value) res = t.k > 0;
+        else res = t.k >= 0;
+        return res ? mk<TRUE> (efac) : mk<FALSE> (efac);
+      }
+
+      inline Expr mkEq (Expr a, Expr b) { return mkCmp<EQ> (a, b); }
+      inline Expr mkNeq (Expr a, Expr b) { return mkCmp<NEQ> (a, b); }
+      inline Expr mkLt (Expr a, Expr b) { return mkCmp<LT> (a, b); }
+      inline Expr mkLeq (Expr a, Expr b) { return mkCmp<LEQ> (a, b); }
+      inline Expr mkGt (Expr a, Expr b) { return mkCmp<GT> (a, b); }
+      inline Expr mkGeq (Expr a, Expr b) { return mkCmp<GEQ> (a, b); }
+
+      /// read of a store chain. Stores to addresses that provably
+      /// differ from idx (constant difference) are skipped, a store to
+      /// the same address gives its value
+      inline Expr mkSelect (Expr arr, Expr idx)
+      {
+        while (isOpX<STORE> (arr))
+        {
+          LinTerm d = diff (arr->arg (1), idx);
+          if (!d.isConst ()) break;
+          if (d.k == 0) return arr->arg (2);
+          arr = arr->arg (0);
+        }
+        if (isOpX<CONST_ARRAY> (arr)) return arr->arg (1);
+        return op::array::select (arr, idx);
+      }
+
+      /// write to a store chain. An earlier store to the same address
+      /// is dropped if only stores to provably different addresses
+      /// follow it
+      inline Expr mkStore (Expr arr, Expr idx, Expr val)
+      {
+        ExprVector skipped;
+        for (Expr a = arr; isOpX<STORE> (a); a = a->arg (0))
+        {
+          LinTerm d = diff (a->arg (1), idx);
+          if (!d.isConst ()) break;
+          if (d.k == 0)
+          {
+            Expr res = a->arg (0);
+            for (auto it = skipped.rbegin (), end = skipped.rend (); it != end; ++it)
+              res = op::array::store (res, (*it)->arg (1), (*it)->arg (2));
+            return op::array::store (res, idx, val);
+          }
+          skipped.push_back (a);
+        }
+        return op::array::store (arr, idx, val);
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,363 @@
+#ifndef _EXPR_REWRITER__HPP_
+#define _EXPR_REWRITER__HPP_
+#include "ufo/Expr.hpp"
+#include "ufo/ExprLinear.hpp"
+
+#include <functional>
+#include <typeinfo>
+#include <typeindex>
+
+/** a fixpoint term rewriter */
+
+namespace expr
+{
+  namespace op
+  {
+    /**
+     * Rewrites expressions to a normal form using a table of rules
+     * indexed by operator. Terms are normalized bottom-up. A rule is
+     * applied to a term whose arguments are already normal and its
+     * result is normalized again, until no rule applies.
+     *
+     * Normal forms are memoized per ENode for the lifetime of the
+     * rewriter, so a sub-term shared between calls is normalized
+     * only once. Entries are dropped when their key dies or when
+     * they are evicted.
+     */
+    class Rewriter
+    {
+    public:
+      /// A rule returns the rewritten term, or null if it does not
+      /// apply. Arguments of the term are in normal form.
+      typedef std::function<Expr (Rewriter&, Expr)> Rule;
+
+    private:
+      ExprFactory &m_efac;
+      Expr trueE;
+      Expr falseE;
+
+      std::map<std::type_index, std::vector<Rule> > m_rules;
+      ExprClockCache<Expr> m_nf;
+
+    public:
+      Rewriter (ExprFactory &efac, size_t capacity = 1 << 18) :
+        m_efac (efac), trueE (mk<TRUE> (efac)), falseE (mk<FALSE> (efac)),
+        m_nf (efac, capacity)
+      {
+        addBoolRules ();
+        addArithRules ();
+        addArrayRules ();
+      }
+
+      ExprFactory &efac () { return m_efac; }
+      const ExprClockCache<Expr> &cache () const { return m_nf; }
+
+      /// adds a rule for terms with operator Op
+      template <typename Op>
+      void addRule (Rule r) { m_rules [std::type_index (typeid (Op))].push_back (r); }
+
+      Expr operator() (Expr e) { return normalize (e); }
+
+      Expr normalize (Expr e)
+      {
+        if (const Expr *nf = m_nf.find (e)) return *nf;
+
+        Expr res = e;
+        if (e->arity () > 0)
+        {
+          ExprVector args;
+          args.reserve (e->arity ());
+          bool changed = false;
+          for (auto a = e->args_begin (), end = e->args_end (); a != end; ++a)
+          {
+            args.push_back (normalize (*a));
+            changed |= args.back () != *a;
+          }
+          if (changed) res = mknary (e->op (), args.begin (), args.end ());
+        }
+
+        Expr r = rewrite (res);
+        if (r && r != res) res = normalize (r);
+
+        m_nf.insert (e, res);
+        if (res != e) m_nf.insert (res, res);
+        return res;
+      }
+
+    private:
+      /// applies the first rule for the operator of e that fires
+      Expr rewrite (Expr e)
+      {
+        auto it = m_rules.find (std::type_index (typeid (e->op ())));
+        if (it == m_rules.end ()) return Expr ();
+        for (Rule &r : it->second)
+        {
+          Expr res = r (*this, e);
+          if (res) return res;
+        }
+        return Expr ();
+      }
+
+      static bool isNum (Expr e) { return isOpX<MPZ> (e); }
+      static mpz_class num (Expr e) { return getTerm<mpz_class> (e); }
+      Expr mkBool (bool v) { return v ? trueE : falseE; }
+
+      static bool idLess (Expr a, Expr b) { return a->getId () < b->getId (); }
+
+      /// -- Boolean rules
+
+      /// flattens, removes units and duplicates, detects
+      /// complementary arguments and absorbs nested clauses of AND
+      /// and OR. Arguments are ordered by id, except that function
+      /// applications (e.g., the predicates of a rule body) stay in
+      /// front
+      template <typename Op>
+      static Expr andOr (Rewriter &rw, Expr e)
+      {
+        bool isAnd = isOpX<AND> (e);
+        Expr unit = rw.mkBool (isAnd);
+        Expr zero = rw.mkBool (!isAnd);
+
+        ExprVector args;
+        for (auto a = e->args_begin (), end = e->args_end (); a != end; ++a)
+        {
+          Expr arg = *a;
+          if (isOp<Op> (arg))
+            args.insert (args.end (), arg->args_begin (), arg->args_end ());
+          else
+            args.push_back (arg);
+        }
+
+        ExprVector res;
+        for (Expr a : args)
+        {
+          if (a == zero) return zero;
+          if (a != unit) res.push_back (a);
+        }
+        std::sort (res.begin (), res.end (), idLess);
+        res.erase (std::unique (res.begin (), res.end ()), res.end ());
+
+        for (Expr a : res)
+          if (isOpX<NEG> (a) &&
+              std::binary_search (res.begin (), res.end (), a->left (), idLess))
+            return zero;
+
+        // -- absorption: a & (a | b) = a, and a & (!a | b) = a & b
+        auto sibling = [&] (Expr a)
+          { return std::binary_search (res.begin (), res.end (), a, idLess); };
+        auto complement = [&] (Expr a)
+          {
+            return (isOpX<NEG> (a) && sibling (a->left ())) ||
+              sibling (mk<NEG> (a));
+          };
+        bool changed = false;
+        ExprVector absorbed;
+        for (Expr a : res)
+        {
+          if (isOpX<AND> (a) == isAnd || !(isOpX<AND> (a) || isOpX<OR> (a)))
+          {
+            absorbed.push_back (a);
+            continue;
+          }
+          ExprVector dual;
+          bool drop = false;
+          for (auto it = a->args_begin (), end = a->args_end (); it != end; ++it)
+          {
+            if (sibling (*it)) drop = true;
+            else if (!complement (*it)) dual.push_back (*it);
+          }
+          changed |= drop || dual.size () != a->arity ();
+          if (drop) continue;
+          if (dual.empty ()) return zero;
+          absorbed.push_back (dual.size () == 1 ? dual [0] :
+                              mknary (a->op (), dual.begin (), dual.end ()));
+        }
+        if (changed) res.swap (absorbed);
+
+        if (res.empty ()) return unit;
+        if (res.size () == 1) return res [0];
+        std::stable_partition (res.begin (), res.end (),
+                               [] (Expr a) { return isOpX<FAPP> (a); });
+        if (!changed && res.size () == e->arity () &&
+            std::equal (res.begin (), res.end (), e->args_begin ())) return Expr ();
+        return mknary<Op> (res.begin (), res.end ());
+      }
+
+      static Expr neg (Rewriter &rw, Expr e)
+      {
+        Expr a = e->left ();
+        if (isOpX<TRUE> (a)) return rw.falseE;
+        if (isOpX<FALSE> (a)) return rw.trueE;
+        if (isOpX<NEG> (a)) return a->left ();
+        if (isOpX<LT> (a)) return mk<GEQ> (a->left (), a->right ());
+        if (isOpX<LEQ> (a)) return mk<GT> (a->left (), a->right ());
+        if (isOpX<GT> (a)) return mk<LEQ> (a->left (), a->right ());
+        if (isOpX<GEQ> (a)) return mk<LT> (a->left (), a->right ());
+        if (isOpX<EQ> (a)) return mk<NEQ> (a->left (), a->right ());
+        if (isOpX<NEQ> (a)) return mk<EQ> (a->left (), a->right ());
+        return Expr ();
+      }
+
+      static Expr impl (Rewriter &rw, Expr e)
+      { return mk<OR> (mk<NEG> (e->left ()), e->right ()); }
+
+      static Expr iff (Rewriter &rw, Expr e)
+      {
+        Expr a = e->left (), b = e->right ();
+        if (a == b) return rw.trueE;
+        if (isOpX<TRUE> (a)) return b;
+        if (isOpX<TRUE> (b)) return a;
+        if (isOpX<FALSE> (a)) return mk<NEG> (b);
+        if (isOpX<FALSE> (b)) return mk<NEG> (a);
+        return Expr ();
+      }
+
+      static Expr xor_ (Rewriter &rw, Expr e)
+      {
+        if (e->arity () != 2) return Expr ();
+        Expr a = e->left (), b = e->right ();
+        if (a == b) return rw.falseE;
+        if (isOpX<FALSE> (a)) return b;
+        if (isOpX<FALSE> (b)) return a;
+        if (isOpX<TRUE> (a)) return mk<NEG> (b);
+        if (isOpX<TRUE> (b)) return mk<NEG> (a);
+        return Expr ();
+      }
+
+      static Expr ite (Rewriter &rw, Expr e)
+      {
+        Expr c = e->arg (0), t = e->arg (1), f = e->arg (2);
+        if (isOpX<TRUE> (c)) return t;
+        if (isOpX<FALSE> (c)) return f;
+        if (t == f) return t;
+        if (isOpX<NEG> (c)) return mk<ITE> (c->left (), f, t);
+        // -- Boolean ite with a constant branch
+        if (isOpX<TRUE> (t)) return mk<OR> (c, f);
+        if (isOpX<FALSE> (t)) return mk<AND> (mk<NEG> (c), f);
+        if (isOpX<TRUE> (f)) return mk<OR> (mk<NEG> (c), t);
+        if (isOpX<FALSE> (f)) return mk<AND> (c, t);
+        return Expr ();
+      }
+
+      void addBoolRules ()
+      {
+        addRule<AND> (&Rewriter::andOr<AND>);
+        addRule<OR> (&Rewriter::andOr<OR>);
+        addRule<NEG> (&Rewriter::neg);
+        addRule<IMPL> (&Rewriter::impl);
+        addRule<IFF> (&Rewriter::iff);
+        addRule<XOR> (&Rewriter::xor_);
+        addRule<ITE> (&Rewriter::ite);
+      }
+
+      /// -- linear arithmetic rules
+
+      /// sums, differences and products by numerals as the canonical
+      /// linear term of ExprLinear
+      static Expr linearTerm (Rewriter &rw, Expr e)
+      {
+        Expr res = linear::linTerm (e).toExpr (rw.m_efac);
+        return res == e ? Expr () : res;
+      }
+
+      /// folds comparisons whose sides differ by a constant
+      template <typename Op>
+      static Expr compare (Rewriter &rw, Expr e)
+      {
+        Expr res = linear::mkCmp<Op> (e->left (), e->right ());
+        return res == e ? Expr () : res;
+      }
+
+      /// lifts an ite with numeral branches over an operator whose
+      /// other arguments are numerals. Both branches then fold to
+      /// constants, so the term does not grow.
+      template <typename Op>
+      static Expr liftIte (Rewriter &rw, Expr e)
+      {
+        int pos = -1;
+        for (unsigned i = 0; i < e->arity (); ++i)
+        {
+          Expr a = e->arg (i);
+          if (isNum (a)) continue;
+          if (pos >= 0 || !isOpX<ITE> (a) ||
+              !isNum (a->arg (1)) || !isNum (a->arg (2))) return Expr ();
+          pos = i;
+        }
+        if (pos < 0) return Expr ();
+
+        Expr c = e->arg (pos)->arg (0);
+        ExprVector t (e->args_begin (), e->args_end ());
+        ExprVector f (t);
+        t [pos] = e->arg (pos)->arg (1);
+        f [pos] = e->arg (pos)->arg (2);
+        return mk<ITE> (c, mknary<Op> (t.begin (), t.end ()),
+                        mknary<Op> (f.begin (), f.end ()));
+      }
+
+      template <typename Op>
+      void addCmpRules ()
+      {
+        addRule<Op> (&Rewriter::compare<Op>);
+        addRule<Op> (&Rewriter::liftIte<Op>);
+      }
+
+      void addArithRules ()
+      {
+        addRule<PLUS> (&Rewriter::linearTerm);
+        addRule<PLUS> (&Rewriter::liftIte<PLUS>);
+        addRule<MULT> (&Rewriter::linearTerm);
+        addRule<MULT> (&Rewriter::liftIte<MULT>);
+        addRule<MINUS> (&Rewriter::linearTerm);
+        addRule<MINUS> (&Rewriter::liftIte<MINUS>);
+        addRule<UN_MINUS> (&Rewriter::linearTerm);
+        addCmpRules<EQ> ();
+        addCmpRules<NEQ> ();
+        addCmpRules<LT> ();
+        addCmpRules<LEQ> ();
+        addCmpRules<GT> ();
+        addCmpRules<GEQ> ();
+      }
+
+      /// -- array rules
+
+      /// indices that are known to be different, i.e., they differ
+      /// by a non-zero constant
+      static bool distinct (Expr i, Expr j)
+      {
+        linear::LinTerm d = linear::diff (i, j);
+        return d.isConst () && d.k != 0;
+      }
+
+      static Expr select (Rewriter &rw, Expr e)
+      {
+        Expr a = e->left (), j = e->right ();
+        if (!isOpX<STORE> (a)) return Expr ();
+        // -- select (store (b, i, v), i) = v
+        if (a->arg (1) == j) return a->arg (2);
+        // -- select (store (b, i, v), j) = select (b, j) if i != j
+        if (distinct (a->arg (1), j)) return mk<SELECT> (a->arg (0), j);
+        return Expr ();
+      }
+
+      static Expr store (Rewriter &rw, Expr e)
+      {
+        Expr a = e->arg (0), i = e->arg (1), v = e->arg (2);
+        // -- store (store (b, i, u), i, v) = store (b, i, v)
+        if (isOpX<STORE> (a) && a->arg (1) == i)
+          return mk<STORE> (a->arg (0), i, v);
+        // -- store (b, i, select (b, i)) = b
+        if (isOpX<SELECT> (v) && v->left () == a && v->right () == i)
+          return a;
+        return Expr ();
+      }
+
+      void addArrayRules ()
+      {
+        addRule<SELECT> (&Rewriter::select);
+        addRule<STORE> (&Rewriter::store);
+      }
+    };
+  }
+}
+
+#endif
@@ -19,6 +19,8 @@
 
 #include <sstream>
 
+#include <zlib.h>
+
 #include <boost/range.hpp>
 #include <boost/range/algorithm/sort.hpp>
 #include <boost/range/algorithm/copy.hpp>
@@ -101,10 +103,14 @@ namespace ufo
     return z3.toExpr (z3::ast (ctx, Z3_simplify (ctx, ast)));
   }
 
+  /// simplified expressions are cached in the context across calls
   template <typename Z>
   Expr z3_simplify (Z &z3, Expr e)
   {
-    return z3_lite_simplify (z3, e);
+    if (const Expr *res = z3.simplifyCache.find (e)) return *res;
+    Expr res = z3_lite_simplify (z3, e);
+    z3.simplifyCache.insert (e, res);
+    return res;
   }
 
 
@@ -166,9 +172,33 @@ namespace ufo
     return z3.toExpr (ast);
   }
 
+  /// Reads a gzip compressed file into res. Returns false if the
+  /// file cannot be read or is not compressed.
+  inline bool z3_read_gz_file (const char *fname, std::string &res)
+  {
+    gzFile f = gzopen (fname, "rb");
+    if (!f) return false;
+
+    char buf [16384];
+    int n = gzread (f, buf, sizeof (buf));
+    // -- gzread passes plain files through, leave those to z3
+    bool ok = n >= 0 && !gzdirect (f);
+    while (ok && n > 0)
+    {
+      res.append (buf, n);
+      n = gzread (f, buf, sizeof (buf));
+      ok = n >= 0;
+    }
+    gzclose (f);
+    return ok;
+  }
+
   template <typename Z>
   Expr z3_from_smtlib_file (Z &z3, const char *fname)
   {
+    std::string smt;
+    if (z3_read_gz_file (fname, smt)) return z3_from_smtlib (z3, smt);
+
     z3::context &ctx = z3.get_ctx ();
     z3::ast ast (ctx, Z3_parse_smtlib2_file (ctx, fname,
                                              0, NULL, NULL, 0, NULL, NULL));
@@ -227,6 +257,8 @@ namespace ufo
     z3::context ctx;
 
     cache_type cache;
+    /// results of z3_simplify
+    ExprClockCache<Expr> simplifyCache;
 
     void init ()
     {
@@ -271,10 +303,12 @@ namespace ufo
 
   public:
 
-    ZContext (ExprFactory &ef) : efac(ef) { init (); }
-    ZContext (ExprFactory &ef, z3::config &c) : efac (ef), ctx(c) { init (); }
+    ZContext (ExprFactory &ef) : efac(ef), simplifyCache (ef, 1 << 14)
+    { init (); }
+    ZContext (ExprFactory &ef, z3::config &c) :
+      efac (ef), ctx(c), simplifyCache (ef, 1 << 14) { init (); }
 
-    ~ZContext () { cache.clear (); }
+    ~ZContext () { simplifyCache.clear (); cache.clear (); }
 
     template <typename V>
     void set (char const *p, V v) { ctx.set (p, v); }
@@ -300,6 +334,9 @@ namespace ufo
 
     ExprFactory &getExprFactory () { return get_efac (); }
 
+    const ExprClockCache<Expr> &getSimplifyCache () const
+    { return simplifyCache; }
+
     friend class ZParams<this_type>;
     friend class ZSolver<this_type>;
     friend class ZModel<this_type>;
@@ -892,6 +929,15 @@ namespace ufo
       return z3.toExpr (res);
     }
 
+    /// Returns the ground counterexample of the last query: a
+    /// conjunction of ground predicate applications along the trace
+    Expr getGroundSatAnswer ()
+    {
+      z3::ast res (ctx, Z3_fixedpoint_get_ground_sat_answer (ctx, fp));
+      ctx.check_error ();
+      return z3.toExpr (res);
+    }
+
     void getCexRules (ExprVector &res)
     {
       z3::ast_vector rules (ctx, 
@@ -1,8 +1,6 @@
 #include "seahorn/Analysis/CanFail.hh"
 #include "seahorn/Transforms/Scalar/PromoteVerifierCalls.hh"
 
-#include "llvm/Analysis/CallGraph.h"
-#include "llvm/ADT/SCCIterator.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "avy/AvyDebug.h"
@@ -12,49 +10,21 @@ namespace seahorn
   
   char CanFail::ID = 0;
   
-  bool CanFail::canFail (const Function *f) const
-  {return m_must.count (f) > 0 || m_may.count (f) > 0;}
-  
   bool CanFail::runOnModule (Module &M)
   {
     LOG ("canfail", errs () << "Running mark-fail analysis\n";);
     
-    if (const Function *errorFn = M.getFunction ("verifier.error"))
-      m_must.insert (errorFn);
-
-    LOG ("canfail", errs () << "Number of must_fail: " << m_must.size () << "\n";);
-    
-    
-    // -- no error function found at all
-    if (m_must.empty ()) return false;
-    
-    CallGraph &CG = getAnalysis<CallGraphWrapperPass> ().getCallGraph ();
-    for (auto it = scc_begin (&CG); !it.isAtEnd (); ++it)
-    {
-      auto &scc = *it;
-      bool mark = false;
-      
-      // -- check if any of the functions in the scc calls something
-      // -- that may fail
-      for (CallGraphNode *cgn : scc)
-      {
-        for (auto &calls : *cgn)
-          if (canFail (calls.second->getFunction ()))
-          {mark=true; break;}
-      }
-      if (mark)
-      {
-        for (auto *cgn : scc)
-          if (cgn->getFunction ())
-            m_may.insert (cgn->getFunction ());
-      }
-    }
+    // -- the summary may predate a transformation that claims to
+    // -- preserve everything
+    ModuleSummary &summary = getAnalysis<ModuleSummary> ();
+    summary.refresh (M);
+    m_summary = &summary;
     
     LOG ("canfail", errs () << "Can fail: ";
-         for (auto v : m_may) errs () << v->getName () << ", ";
+         for (auto &F : M) 
+           if (canFail (&F)) errs () << F.getName () << ", ";
          errs () << "\n";);
     
-      
     return false;
   }
   
@@ -62,8 +32,7 @@ namespace seahorn
   {
     AU.setPreservesAll ();
     AU.addRequired<PromoteVerifierCalls> ();
-    AU.addRequired<CallGraphWrapperPass> ();
-    AU.addPreserved<CallGraphWrapperPass> ();
+    AU.addRequiredTransitive<ModuleSummary> ();
   }
 }
 
@@ -11,6 +11,8 @@
 
 #include "llvm/Support/CommandLine.h"
 
+#include "seahorn/Analysis/ModuleSummary.hh"
+
 using namespace llvm;
 
 static llvm::cl::opt<bool>
@@ -57,9 +59,13 @@ namespace seahorn {
       
       bool Changed = false;
       
-      //Iterate over all functions, basic blocks and instructions.
+      ModuleSummary &summary = getAnalysis<ModuleSummary> ();
+      summary.refresh (M);
+      
+      // -- only functions that read undef need to be reported
       for (Module::iterator FI = M.begin(), E = M.end(); FI != E; ++FI)
-        Changed |= runOnFunction (*FI);
+        if (summary.readsUndef (&*FI))
+          Changed |= runOnFunction (*FI);
 
 
       if (UndefWarningErr && m_undef_found) {
@@ -147,6 +153,7 @@ namespace seahorn {
 
     virtual void getAnalysisUsage (AnalysisUsage &AU) const  {
       AU.setPreservesAll ();
+      AU.addRequired<ModuleSummary> ();
     }
     
   };
@@ -38,21 +38,22 @@ namespace seahorn
 
   void CutPointGraph::computeCutPoints (const Function &F, const TopologicalOrder &topo)
   {
-
-    for (const BasicBlock *bb : topo)
+    const CfgSnapshot &cfg = topo.cfg ();
+    for (unsigned i = 0; i < cfg.size (); ++i)
     {
+      const BasicBlock *bb = cfg.block (i);
       // -- skip basic blocks that are already marked as cut-points
       if (isCutPoint (*bb)) continue;
       
       // entry
-      if (pred_begin (bb) == pred_end (bb))
+      if (cfg.preds (i).empty ())
       {
         LOG ("cpg", errs () << "entry cp: " << bb->getName () << "\n");
         newCp (*bb);
       }
       
       // exit
-      if (succ_begin (bb) == succ_end (bb))
+      if (cfg.succs (i).empty ())
       {
         LOG ("cpg", errs () << "exit cp: " << bb->getName () << "\n");
         newCp (*bb);
@@ -60,9 +61,8 @@ namespace seahorn
       
 
       // has incoming back-edge
-      for (const BasicBlock *pred :
-             boost::make_iterator_range (pred_begin (bb), pred_end (bb)))
-        if (topo.isBackEdge (*pred, *bb))
+      for (unsigned pred : cfg.preds (i))
+        if (cfg.isBackEdge (pred, i))
         {
           LOG ("cpg", errs () << "back-edge cp: " << bb->getName () << "\n");
           newCp (*bb);
@@ -70,27 +70,26 @@ namespace seahorn
       
     }
 
-  }
+    for (unsigned i = 0; i < cfg.size (); ++i) m_num [cfg.block (i)] = i;
 
-  void setbit (llvm::BitVector &b, unsigned idx)
-  {
-    if (idx >= b.size ()) b.resize (idx + 1);
-    b.set (idx);
+    m_cpId.assign (cfg.size (), -1);
+    for (auto &cp : m_cps) m_cpId [cfg.number (cp->bb ())] = cp->id ();
   }
 
   void CutPointGraph::computeFwdReach (const Function &F, const TopologicalOrder &topo)
   {
-    for (auto it = topo.rbegin (), end = topo.rend (); it != end; ++it)
-    {
-      const BasicBlock *bb = *it;
+    const CfgSnapshot &cfg = topo.cfg ();
+    m_fwd.assign (cfg.size (), BitSet (m_cps.size ()));
 
-      BitVector &r = m_fwd [bb];
-      for (const BasicBlock *succ : succs (*bb))
+    for (unsigned i = cfg.size (); i-- > 0; )
+    {
+      BitSet &r = m_fwd [i];
+      for (unsigned succ : cfg.succs (i))
       {
-        if (isCutPoint (*succ))
-          setbit (r, getCp (*succ).id ());
+        if (m_cpId [succ] >= 0)
+          r.set (m_cpId [succ]);
         else
-          r |= m_fwd [succ];
+          r.unionWith (m_fwd [succ]);
       }
     }
 
@@ -98,46 +97,48 @@ namespace seahorn
 
   void CutPointGraph::computeBwdReach (const Function &F, const TopologicalOrder &topo)
   {
-    for (const BasicBlock *bb : topo)
+    const CfgSnapshot &cfg = topo.cfg ();
+    m_bwd.assign (cfg.size (), BitSet (m_cps.size ()));
+
+    for (unsigned i = 0; i < cfg.size (); ++i)
     {
-      BitVector &r = m_bwd [bb];
-      const BasicBlock &BB = *bb;
-      for (const BasicBlock *pred :
-             boost::make_iterator_range (pred_begin (bb), pred_end (bb)))
+      BitSet &r = m_bwd [i];
+      for (unsigned pred : cfg.preds (i))
       {
-        if (topo.isBackEdge (*pred, BB)) continue;
-        if (isCutPoint (*pred))
-          setbit (r, getCp (*pred).id ());
+        if (cfg.isBackEdge (pred, i)) continue;
+        if (m_cpId [pred] >= 0)
+          r.set (m_cpId [pred]);
         else
-          r |= m_bwd [pred];
+          r.unionWith (m_bwd [pred]);
       }
     }
 
     for (const CutPoint &cp : boost::make_iterator_range (begin (), end ()))
     {
-      const BasicBlock *bb = &cp.bb ();
-      BitVector &r = m_bwd [bb];
+      unsigned i = cfg.number (cp.bb ());
+      BitSet &r = m_bwd [i];
 
-      for (const BasicBlock *pred :
-             boost::make_iterator_range (pred_begin (bb), pred_end (bb)))
+      for (unsigned pred : cfg.preds (i))
       {
-        if (! topo.isBackEdge (*pred, *bb)) continue;
-        if (isCutPoint (*pred))
-          setbit (r, getCp (*pred).id ());
+        if (! cfg.isBackEdge (pred, i)) continue;
+        if (m_cpId [pred] >= 0)
+          r.set (m_cpId [pred]);
         else
-          r |= m_bwd [pred];
+          r.unionWith (m_bwd [pred]);
       }
     }
   }
 
   void CutPointGraph::computeEdges (const Function &F, const TopologicalOrder &topo)
   {
-    for (const BasicBlock *bb : topo)
+    const CfgSnapshot &cfg = topo.cfg ();
+    for (unsigned n = 0; n < cfg.size (); ++n)
     {
-      if (isCutPoint (*bb))
+      const BasicBlock *bb = cfg.block (n);
+      if (m_cpId [n] >= 0)
       {
-        BitVector &r = m_fwd [bb];
-        CutPoint &cp = getCp (*bb);
+        BitSet &r = m_fwd [n];
+        CutPoint &cp = *m_cps [m_cpId [n]];
         for (int i = r.find_first (); i >= 0; i = r.find_next (i))
         {
           CpEdge &edg = newEdge (cp, *m_cps [i]);
@@ -146,8 +147,8 @@ namespace seahorn
       }
       else
       {
-        BitVector &b = m_bwd[bb];
-        BitVector &f = m_fwd[bb];
+        BitSet &b = m_bwd[n];
+        BitSet &f = m_fwd[n];
 
         for (int i = b.find_first (); i >= 0; i = b.find_next (i))
           for (int j = f.find_first (); j >= 0; j = f.find_next (j))
@@ -206,13 +207,11 @@ namespace seahorn
     // cannot reach another cut-point without getting to it
     if (isCutPoint (bb)) return false;
 
-    auto it = m_bwd.find (&bb);
-    assert (it != m_bwd.end ());
+    // -- not reachable from the entry
+    auto it = m_num.find (&bb);
+    if (it == m_num.end ()) return false;
 
-    unsigned sz = it->second.size ();
-    unsigned id = cp.id ();
-    if (sz == 0 || id >= sz) return false;
-    return (it->second)[id];
+    return m_bwd [it->second].test (cp.id ());
   }
 
 }
@@ -0,0 +1,134 @@
+#include "seahorn/Analysis/ModuleSummary.hh"
+
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/Analysis/CFG.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "avy/AvyDebug.h"
+
+namespace seahorn
+{
+  using namespace llvm;
+
+  char ModuleSummary::ID = 0;
+
+  static const Function *calledFunction (ImmutableCallSite CS)
+  {
+    return dyn_cast<Function> (CS.getCalledValue ()->stripPointerCasts ());
+  }
+
+  void ModuleSummary::compute (Module &M)
+  {
+    m_flags.clear ();
+
+    const Function *errorFn = M.getFunction ("verifier.error");
+    const Function *failFn = M.getFunction ("seahorn.fail");
+
+    // -- callers of every function, for the propagation below
+    DenseMap<const Function*, SmallVector<const Function*, 4> > callers;
+
+    // -- the sweep: local facts of every function
+    for (const Function &F : M)
+    {
+      unsigned &fl = m_flags [&F];
+      if (&F == errorFn) fl |= MUST_FAIL;
+      if (F.isDeclaration ()) continue;
+
+      for (const BasicBlock &BB : F)
+        for (const Instruction &I : BB)
+        {
+          for (unsigned i = 0, e = I.getNumOperands (); i < e; ++i)
+            if (isa<UndefValue> (I.getOperand (i))) fl |= READS_UNDEF;
+
+          if (isa<LoadInst> (I) || isa<StoreInst> (I))
+          {
+            fl |= MUST_ACCESS_MEM;
+            continue;
+          }
+
+          ImmutableCallSite CS (&I);
+          if (!CS) continue;
+          const Function *cf = calledFunction (CS);
+          if (!cf) continue;
+
+          callers [cf].push_back (&F);
+          StringRef name = cf->getName ();
+          if (cf == errorFn) fl |= CALLS_ERROR;
+          else if (cf == failFn) fl |= CALLS_SEAHORN_FAIL;
+          else if (name.equals ("verifier.assume") ||
+                   name.equals ("verifier.assume.not"))
+            fl |= CALLS_ASSUME;
+          else if (name.startswith ("llvm.memcpy") ||
+                   name.startswith ("llvm.memmove") ||
+                   name.startswith ("llvm.memset"))
+            fl |= MUST_ACCESS_MEM;
+        }
+
+      SmallVector<std::pair<const BasicBlock*, const BasicBlock*>, 8> backEdges;
+      FindFunctionBackedges (F, backEdges);
+      if (!backEdges.empty ()) fl |= HAS_LOOP;
+    }
+
+    // -- propagate may-fail and may-access-memory to the callers
+    // -- (same result as marking every SCC of the call graph that
+    // -- calls a function with the property)
+    auto propagate = [&] (unsigned must, unsigned may)
+    {
+      SmallVector<const Function*, 32> wl;
+      for (auto &kv : m_flags)
+        if (kv.second & must) wl.push_back (kv.first);
+
+      while (!wl.empty ())
+      {
+        const Function *f = wl.pop_back_val ();
+        auto it = callers.find (f);
+        if (it == callers.end ()) continue;
+        for (const Function *caller : it->second)
+        {
+          unsigned &fl = m_flags [caller];
+          if (fl & may) continue;
+          fl |= may;
+          wl.push_back (caller);
+        }
+      }
+    };
+    propagate (MUST_FAIL, MAY_FAIL);
+    propagate (MUST_ACCESS_MEM, MAY_ACCESS_MEM);
+  }
+
+  void ModuleSummary::refresh (Module &M)
+  {
+    if (m_valid) return;
+    LOG ("summary", errs () << "Computing module summary\n";);
+    compute (M);
+    m_valid = true;
+  }
+
+  bool ModuleSummary::anyMayFail (const Module &M) const
+  {
+    const Function *errorFn = M.getFunction ("verifier.error");
+    const Function *failFn = M.getFunction ("seahorn.fail");
+    for (auto &kv : m_flags)
+    {
+      if (kv.first == errorFn || kv.first == failFn) continue;
+      if (kv.second & (MUST_FAIL | MAY_FAIL)) return true;
+    }
+    return false;
+  }
+
+  bool ModuleSummary::runOnModule (Module &M)
+  {
+    m_valid = false;
+    refresh (M);
+    return false;
+  }
+
+  void ModuleSummary::getAnalysisUsage (AnalysisUsage &AU) const
+  {AU.setPreservesAll ();}
+}
+
+static llvm::RegisterPass<seahorn::ModuleSummary>
+X ("module-summary", "Summarize properties of all functions in one sweep");
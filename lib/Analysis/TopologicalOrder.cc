@@ -1,11 +1,6 @@
 #include "seahorn/Analysis/TopologicalOrder.hh"
 
-#include "seahorn/Support/SortTopo.hh"
-#include "llvm/Analysis/CFG.h"
-
-#include "boost/range/algorithm/reverse.hpp"
-#include "boost/range/algorithm/sort.hpp"
-#include "boost/range/algorithm/binary_search.hpp"
+#include "llvm/Support/raw_ostream.h"
 
 namespace seahorn
 {
@@ -18,21 +13,15 @@ namespace seahorn
   
   bool TopologicalOrder::runOnFunction (Function &F)
   {
-    m_backEdges.clear ();
-    m_order.clear ();
-    
-    FindFunctionBackedges (F, m_backEdges);
-    boost::sort (m_backEdges);
-      
-    RevTopoSort (F, m_order);
-    boost::reverse (m_order);
-      
+    m_cfg.build (F);
     return false;
   }
   
   bool TopologicalOrder::isBackEdge (const BasicBlock &src, const BasicBlock &dst) const
   {
-    return boost::binary_search (m_backEdges, std::make_pair (&src, &dst));
+    // -- only edges between reachable blocks are back-edges
+    if (!m_cfg.contains (src) || !m_cfg.contains (dst)) return false;
+    return m_cfg.isBackEdge (m_cfg.number (src), m_cfg.number (dst));
   }
   
   void TopologicalOrder::print (raw_ostream &out, const Module *m) const
@@ -0,0 +1,198 @@
+#include "seahorn/Support/BitSet.hh"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace seahorn
+{
+  void BitSet::allocate (unsigned sz)
+  {
+    m_size = sz;
+    m_nwords = (sz + WordBits * LineWords - 1) / (WordBits * LineWords) * LineWords;
+    if (m_nwords == 0)
+    {
+      m_alloc = m_words = NULL;
+      return;
+    }
+
+    // -- over-allocate by one line and start at the first aligned word
+    m_alloc = new Word [m_nwords + LineWords];
+    uintptr_t p = reinterpret_cast<uintptr_t> (m_alloc);
+    uintptr_t line = sizeof (Word) * LineWords;
+    m_words = reinterpret_cast<Word*> ((p + line - 1) & ~(line - 1));
+    clear ();
+  }
+
+  BitSet::BitSet (const BitSet &o) : m_alloc (NULL), m_words (NULL)
+  {
+    allocate (o.m_size);
+    if (m_nwords) std::memcpy (m_words, o.m_words, m_nwords * sizeof (Word));
+  }
+
+#if defined(__AVX2__)
+  // -- 4 words per step. Sizes are multiples of 8 words
+  bool BitSet::unionWith (const BitSet &o)
+  {
+    assert (m_size == o.m_size);
+    __m256i diff = _mm256_setzero_si256 ();
+    for (unsigned i = 0; i < m_nwords; i += 4)
+    {
+      __m256i *d = reinterpret_cast<__m256i*> (m_words + i);
+      __m256i a = _mm256_load_si256 (d);
+      __m256i b = _mm256_load_si256 (reinterpret_cast<const __m256i*> (o.m_words + i));
+      diff = _mm256_or_si256 (diff, _mm256_andnot_si256 (a, b));
+      _mm256_store_si256 (d, _mm256_or_si256 (a, b));
+    }
+    return !_mm256_testz_si256 (diff, diff);
+  }
+
+  bool BitSet::unionWithout (const BitSet &o, const BitSet &mask)
+  {
+    assert (m_size == o.m_size && m_size == mask.m_size);
+    __m256i diff = _mm256_setzero_si256 ();
+    for (unsigned i = 0; i < m_nwords; i += 4)
+    {
+      __m256i *d = reinterpret_cast<__m256i*> (m_words + i);
+      __m256i a = _mm256_load_si256 (d);
+      __m256i b = _mm256_load_si256 (reinterpret_cast<const __m256i*> (o.m_words + i));
+      __m256i m = _mm256_load_si256 (reinterpret_cast<const __m256i*> (mask.m_words + i));
+      b = _mm256_andnot_si256 (m, b);
+      diff = _mm256_or_si256 (diff, _mm256_andnot_si256 (a, b));
+      _mm256_store_si256 (d, _mm256_or_si256 (a, b));
+    }
+    return !_mm256_testz_si256 (diff, diff);
+  }
+
+  void BitSet::subtract (const BitSet &o)
+  {
+    assert (m_size == o.m_size);
+    for (unsigned i = 0; i < m_nwords; i += 4)
+    {
+      __m256i *d = reinterpret_cast<__m256i*> (m_words + i);
+      __m256i b = _mm256_load_si256 (reinterpret_cast<const __m256i*> (o.m_words + i));
+      _mm256_store_si256 (d, _mm256_andnot_si256 (b, _mm256_load_si256 (d)));
+    }
+  }
+
+  bool BitSet::any () const
+  {
+    __m256i acc = _mm256_setzero_si256 ();
+    for (unsigned i = 0; i < m_nwords; i += 4)
+      acc = _mm256_or_si256
+        (acc, _mm256_load_si256 (reinterpret_cast<const __m256i*> (m_words + i)));
+    return !_mm256_testz_si256 (acc, acc);
+  }
+
+#elif defined(__SSE2__)
+  // -- 2 words per step
+  static inline bool isZero (__m128i v)
+  {
+    return _mm_movemask_epi8 (_mm_cmpeq_epi8 (v, _mm_setzero_si128 ())) == 0xFFFF;
+  }
+
+  bool BitSet::unionWith (const BitSet &o)
+  {
+    assert (m_size == o.m_size);
+    __m128i diff = _mm_setzero_si128 ();
+    for (unsigned i = 0; i < m_nwords; i += 2)
+    {
+      __m128i *d = reinterpret_cast<__m128i*> (m_words + i);
+      __m128i a = _mm_load_si128 (d);
+      __m128i b = _mm_load_si128 (reinterpret_cast<const __m128i*> (o.m_words + i));
+      diff = _mm_or_si128 (diff, _mm_andnot_si128 (a, b));
+      _mm_store_si128 (d, _mm_or_si128 (a, b));
+    }
+    return !isZero (diff);
+  }
+
+  bool BitSet::unionWithout (const BitSet &o, const BitSet &mask)
+  {
+    assert (m_size == o.m_size && m_size == mask.m_size);
+    __m128i diff = _mm_setzero_si128 ();
+    for (unsigned i = 0; i < m_nwords; i += 2)
+    {
+      __m128i *d = reinterpret_cast<__m128i*> (m_words + i);
+      __m128i a = _mm_load_si128 (d);
+      __m128i b = _mm_load_si128 (reinterpret_cast<const __m128i*> (o.m_words + i));
+      __m128i m = _mm_load_si128 (reinterpret_cast<const __m128i*> (mask.m_words + i));
+      b = _mm_andnot_si128 (m, b);
+      diff = _mm_or_si128 (diff, _mm_andnot_si128 (a, b));
+      _mm_store_si128 (d, _mm_or_si128 (a, b));
+    }
+    return !isZero (diff);
+  }
+
+  void BitSet::subtract (const BitSet &o)
+  {
+    assert (m_size == o.m_size);
+    for (unsigned i = 0; i < m_nwords; i += 2)
+    {
+      __m128i *d = reinterpret_cast<__m128i*> (m_words + i);
+      __m128i b = _mm_load_si128 (reinterpret_cast<const __m128i*> (o.m_words + i));
+      _mm_store_si128 (d, _mm_andnot_si128 (b, _mm_load_si128 (d)));
+    }
+  }
+
+  bool BitSet::any () const
+  {
+    __m128i acc = _mm_setzero_si128 ();
+    for (unsigned i = 0; i < m_nwords; i += 2)
+      acc = _mm_or_si128
+        (acc, _mm_load_si128 (reinterpret_cast<const __m128i*> (m_words + i)));
+    return !isZero (acc);
+  }
+
+#else
+  bool BitSet::unionWith (const BitSet &o)
+  {
+    assert (m_size == o.m_size);
+    Word diff = 0;
+    for (unsigned i = 0; i < m_nwords; ++i)
+    {
+      diff |= o.m_words [i] & ~m_words [i];
+      m_words [i] |= o.m_words [i];
+    }
+    return diff != 0;
+  }
+
+  bool BitSet::unionWithout (const BitSet &o, const BitSet &mask)
+  {
+    assert (m_size == o.m_size && m_size == mask.m_size);
+    Word diff = 0;
+    for (unsigned i = 0; i < m_nwords; ++i)
+    {
+      Word b = o.m_words [i] & ~mask.m_words [i];
+      diff |= b & ~m_words [i];
+      m_words [i] |= b;
+    }
+    return diff != 0;
+  }
+
+  void BitSet::subtract (const BitSet &o)
+  {
+    assert (m_size == o.m_size);
+    for (unsigned i = 0; i < m_nwords; ++i) m_words [i] &= ~o.m_words [i];
+  }
+
+  bool BitSet::any () const
+  {
+    Word acc = 0;
+    for (unsigned i = 0; i < m_nwords; ++i) acc |= m_words [i];
+    return acc != 0;
+  }
+#endif
+
+  unsigned BitSet::count () const
+  {
+    // -- compiles to popcnt when the target has it
+    unsigned res = 0;
+    for (unsigned i = 0; i < m_nwords; ++i)
+      res += llvm::countPopulation (m_words [i]);
+    return res;
+  }
+}
@@ -0,0 +1,53 @@
+#include "seahorn/Support/CfgSnapshot.hh"
+#include "seahorn/Support/SortTopo.hh"
+
+#include "llvm/IR/CFG.h"
+
+#include <algorithm>
+
+namespace seahorn
+{
+  void CfgSnapshot::clear ()
+  {
+    m_blocks.clear ();
+    m_num.clear ();
+    m_succOff.clear ();
+    m_succ.clear ();
+    m_predOff.clear ();
+    m_pred.clear ();
+  }
+
+  void CfgSnapshot::build (const Function &F)
+  {
+    clear ();
+    RevTopoSort (F, m_blocks);
+    std::reverse (m_blocks.begin (), m_blocks.end ());
+
+    unsigned n = m_blocks.size ();
+    for (unsigned i = 0; i < n; ++i) m_num [m_blocks [i]] = i;
+
+    // -- successors
+    m_succOff.reserve (n + 1);
+    for (const BasicBlock *bb : m_blocks)
+    {
+      m_succOff.push_back (m_succ.size ());
+      for (auto it = succ_begin (bb), end = succ_end (bb); it != end; ++it)
+        m_succ.push_back (m_num.lookup (*it));
+    }
+    m_succOff.push_back (m_succ.size ());
+
+    // -- predecessors, in the order of pred_begin
+    m_predOff.reserve (n + 1);
+    m_pred.reserve (m_succ.size ());
+    for (const BasicBlock *bb : m_blocks)
+    {
+      m_predOff.push_back (m_pred.size ());
+      for (auto it = pred_begin (bb), end = pred_end (bb); it != end; ++it)
+      {
+        auto num = m_num.find (*it);
+        if (num != m_num.end ()) m_pred.push_back (num->second);
+      }
+    }
+    m_predOff.push_back (m_pred.size ());
+  }
+}
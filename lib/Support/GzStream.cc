@@ -0,0 +1,59 @@
+#include "seahorn/Support/GzStream.hh"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <climits>
+
+namespace seahorn
+{
+  raw_gz_ostream::raw_gz_ostream (llvm::raw_ostream &out, int level) :
+    m_out (out), m_zs (new z_stream), m_pos (0)
+  {
+    m_zs->zalloc = Z_NULL;
+    m_zs->zfree = Z_NULL;
+    m_zs->opaque = Z_NULL;
+    // -- 15 bits of window plus 16 selects the gzip wrapper
+    int ret = deflateInit2 (m_zs.get (), level, Z_DEFLATED,
+                            15 + 16, 8, Z_DEFAULT_STRATEGY);
+    assert (ret == Z_OK);
+    (void)ret;
+  }
+
+  raw_gz_ostream::~raw_gz_ostream ()
+  {
+    flush ();
+    deflateTo (Z_FINISH);
+    deflateEnd (m_zs.get ());
+    m_out.flush ();
+  }
+
+  void raw_gz_ostream::write_impl (const char *ptr, size_t size)
+  {
+    m_pos += size;
+    // -- avail_in is a uInt, so feed larger buffers in pieces
+    while (size > 0)
+    {
+      uInt chunk = static_cast<uInt> (std::min<size_t> (size, UINT_MAX));
+      m_zs->next_in = reinterpret_cast<Bytef*> (const_cast<char*> (ptr));
+      m_zs->avail_in = chunk;
+      deflateTo (Z_NO_FLUSH);
+      ptr += chunk;
+      size -= chunk;
+    }
+  }
+
+  void raw_gz_ostream::deflateTo (int flush)
+  {
+    char buf [16384];
+    do
+    {
+      m_zs->next_out = reinterpret_cast<Bytef*> (buf);
+      m_zs->avail_out = sizeof (buf);
+      int ret = deflate (m_zs.get (), flush);
+      assert (ret != Z_STREAM_ERROR);
+      (void)ret;
+      m_out.write (buf, sizeof (buf) - m_zs->avail_out);
+    } while (m_zs->avail_out == 0);
+  }
+}
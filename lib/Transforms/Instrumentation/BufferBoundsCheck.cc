@@ -32,6 +32,7 @@
 
 #include "seahorn/Transforms/Instrumentation/BufferBoundsCheck.hh"
 #include "seahorn/Transforms/Instrumentation/ShadowBufferBoundsCheckFuncPars.hh"
+#include "seahorn/Analysis/ModuleSummary.hh"
 
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Transforms/Utils/UnifyFunctionExitNodes.h"
@@ -1129,6 +1130,10 @@ bool BufferBoundsCheck::runOnModule (llvm::Module &M)
 
 	for (Function &F : M) change |= runOnFunction (F);
 
+	if (change)
+		if (ModuleSummary *ms = getAnalysisIfAvailable<ModuleSummary> ())
+			ms->invalidate ();
+
 	LOG( "boc-stats",
 	     errs ()
 	     << "[BOA] checks added: " << ChecksAdded << "\n"
@@ -31,6 +31,8 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/ADT/APInt.h"
 
+#include "seahorn/Analysis/ModuleSummary.hh"
+
 #include "avy/AvyDebug.h"
 
 static llvm::cl::opt<bool>
@@ -284,6 +286,10 @@ namespace seahorn
       change |= runOnFunction (F); 
     }
 
+    if (change)
+      if (ModuleSummary *ms = getAnalysisIfAvailable<ModuleSummary> ())
+        ms->invalidate ();
+
     errs () << "-- Inserted " << ChecksAdded << " signed integer overflow checks.\n";
     return change;
   }
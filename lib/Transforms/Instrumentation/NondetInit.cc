@@ -31,6 +31,8 @@ DM-0002198
 #include "llvm/ADT/Statistic.h"
 #include "boost/format.hpp"
 
+#include "seahorn/Analysis/ModuleSummary.hh"
+
 #include <map>
 #include <forward_list>
 
@@ -95,6 +97,11 @@ namespace seahorn
       //Iterate over all functions, basic blocks and instructions.
       for (Module::iterator FI = M.begin(), E = M.end(); FI != E; ++FI)
 	Changed |= runOnFunction (*FI);
+
+      // -- undef operands are gone
+      if (Changed)
+        if (ModuleSummary *ms = getAnalysisIfAvailable<ModuleSummary> ())
+          ms->invalidate ();
 	  
       return Changed;
     }
@@ -10,6 +10,8 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/CommandLine.h"
 
+#include "seahorn/Analysis/ModuleSummary.hh"
+
 #include "avy/AvyDebug.h"
 
 namespace seahorn
@@ -148,6 +150,10 @@ namespace seahorn
       change |= runOnFunction (F); 
     }
 
+    if (change)
+      if (ModuleSummary *ms = getAnalysisIfAvailable<ModuleSummary> ())
+        ms->invalidate ();
+
     errs () << "-- Inserted " << ChecksAdded << " null dereference checks " 
             << " (skipped " << TrivialChecks << " trivial checks).\n";
 
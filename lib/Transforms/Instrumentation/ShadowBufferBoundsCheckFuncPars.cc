@@ -320,6 +320,10 @@ namespace seahorn
     for (unsigned i=0, e = oldFuncs.size(); i!=e; ++i)
       change |= addFunShadowParams (oldFuncs [i], ctx);
 
+    if (change)
+      if (ModuleSummary *ms = getAnalysisIfAvailable<ModuleSummary> ())
+        ms->invalidate ();
+
     return change;
   }
 
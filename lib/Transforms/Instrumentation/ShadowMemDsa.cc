@@ -7,6 +7,8 @@
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include "llvm/Transforms/Utils/Local.h"
 
+#include "seahorn/Analysis/ModuleSummary.hh"
+
 #include "avy/AvyDebug.h"
 #include "boost/range.hpp"
 #include "boost/range/algorithm/sort.hpp"
@@ -176,6 +178,10 @@ namespace seahorn
                                         (Type*) 0);
      m_node_ids.clear ();
      for (Function &f : M) runOnFunction (f);
+
+     // -- shadow.mem calls and loads of the shadow allocas were added
+     if (ModuleSummary *ms = getAnalysisIfAvailable<ModuleSummary> ())
+       ms->invalidate ();
       
      return false;
   }
@@ -195,6 +201,65 @@ namespace seahorn
     return ConstantPointerNull::get (Type::getInt8PtrTy (ctx));
   }
   
+  /// Replaces the verifier.gv.init calls of F by a single call per
+  /// DSA node, with all globals of the node as arguments. A node
+  /// that also holds memory not initialized by the calls (heap,
+  /// stack, unknown, or another global) keeps its previous contents
+  /// and its calls are removed
+  void ShadowMemDsa::mergeGvInits (Function &F, DSGraph *dsg, DSGraph *gDsg)
+  {
+    Function *initFn = F.getParent ()->getFunction ("verifier.gv.init");
+    if (!initFn) return;
+
+    // -- calls by node, in program order
+    DenseMap<const DSNode*, SmallVector<CallInst*, 4> > calls;
+    std::vector<const DSNode*> nodes;
+    SmallVector<CallInst*, 8> orphans;
+    for (BasicBlock &bb : F)
+      for (Instruction &inst : bb)
+      {
+        CallInst *call = dyn_cast<CallInst> (&inst);
+        if (!call || call->getCalledFunction () != initFn) continue;
+        const Value *ptr = call->getArgOperand (0)->stripPointerCasts ();
+        DSNode *n = dsg->getNodeForValue (ptr).getNode ();
+        if (!n) n = gDsg->getNodeForValue (ptr).getNode ();
+        if (!n) { orphans.push_back (call); continue; }
+        if (!calls.count (n)) nodes.push_back (n);
+        calls [n].push_back (call);
+      }
+    for (CallInst *call : orphans) call->eraseFromParent ();
+
+    for (const DSNode *n : nodes)
+    {
+      auto &cs = calls [n];
+      std::set<const Value*> covered;
+      SmallVector<Value*, 8> args;
+      for (CallInst *call : cs)
+      {
+        covered.insert (call->getArgOperand (0)->stripPointerCasts ());
+        args.push_back (call->getArgOperand (0));
+      }
+
+      bool whole = !n->isHeapNode () && !n->isAllocaNode () &&
+        !n->isUnknownNode () && n->isGlobalNode ();
+      if (whole)
+      {
+        svset<const GlobalValue*> gvs;
+        n->addFullGlobalsSet (gvs);
+        for (const GlobalValue *gv : gvs)
+          if (isa<GlobalVariable> (gv) && !covered.count (gv)) whole = false;
+      }
+
+      if (whole && cs.size () > 1)
+      {
+        CallInst *merged = CallInst::Create (initFn, args, "", cs.front ());
+        merged->setDebugLoc (cs.front ()->getDebugLoc ());
+      }
+      if (whole && cs.size () == 1) continue;
+      for (CallInst *call : cs) call->eraseFromParent ();
+    }
+  }
+
   bool ShadowMemDsa::runOnFunction (Function &F)
   {
     if (F.isDeclaration ()) return false;
@@ -220,6 +285,8 @@ namespace seahorn
     
     m_shadows.clear ();
     // -- preserve ids across functions m_node_ids.clear ();
+
+    mergeGvInits (F, dsg, gDsg);
       
     LLVMContext &ctx = F.getContext ();
     IRBuilder<> B (ctx);
@@ -262,9 +329,16 @@ namespace seahorn
 
           if (!CS.getCalleeFunc ()) continue;
           
-          if (CS.getCalleeFunc ()->getName ().equals ("calloc"))
+          if (CS.getCalleeFunc ()->getName ().equals ("calloc") ||
+              CS.getCalleeFunc ()->getName ().equals ("verifier.gv.init"))
           {
-            DSNode* n = dsg->getNodeForValue (call).getNode ();
+            // -- calloc writes the returned node, verifier.gv.init
+            // -- the node of its arguments (see mergeGvInits)
+            const Value *ptr = call;
+            if (CS.getCalleeFunc ()->getName ().equals ("verifier.gv.init"))
+              ptr = call->getArgOperand (0)->stripPointerCasts ();
+            DSNode* n = dsg->getNodeForValue (ptr).getNode ();
+            if (!n) n = gDsg->getNodeForValue (ptr).getNode ();
             if (!n) continue;
             B.SetInsertPoint (call);
             AllocaInst *v = allocaForNode (n);
@@ -498,6 +572,9 @@ namespace seahorn
           RecursivelyDeleteTriviallyDeadInstructions (last);
         }
       }
+
+      if (ModuleSummary *ms = getAnalysisIfAvailable<ModuleSummary> ())
+        ms->invalidate ();
       
       return true;
     }
@@ -24,6 +24,8 @@ DM-0002198
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Module.h"
 
+#include "seahorn/Analysis/ModuleSummary.hh"
+
 namespace
 {
   using namespace llvm;
@@ -39,6 +41,10 @@ namespace
       bool changed = false;
       for (Module::iterator FI = M.begin (), E = M.end (); FI != E; ++FI)
         if (FI->isVarArg ()) FI->deleteBody (), changed = true;
+
+      if (changed)
+        if (auto *ms = getAnalysisIfAvailable<seahorn::ModuleSummary> ())
+          ms->invalidate ();
       
       return changed;
     }
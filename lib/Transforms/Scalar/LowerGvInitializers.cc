@@ -1,45 +1,85 @@
 #include "seahorn/Transforms/Scalar/LowerGvInitializers.hh"
+#include "seahorn/Analysis/ModuleSummary.hh"
 
 #include "boost/range.hpp"
 
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/IR/IRBuilder.h"
 
+static llvm::cl::opt<bool>
+LowerAggregates ("lower-gv-init-aggregates",
+                 llvm::cl::desc ("Lower initializers of global arrays, structs "
+                                 "and pointers to one verifier.gv.init call "
+                                 "per global"),
+                 llvm::cl::init (true));
+
 namespace seahorn
 {
   char LowerGvInitializers::ID = 0;
-  
+
+  /// marks a module that has already been lowered
+  static const char *LoweredMd = "seahorn.gv.init.lowered";
+
   bool LowerGvInitializers::runOnModule (Module &M) {
 
+    // -- the pass runs both in seapp and in seahorn
+    if (M.getNamedMetadata (LoweredMd)) return false;
+
     const DataLayout* DL = &getAnalysis<DataLayoutPass>().getDataLayout ();
 
     Function *f = M.getFunction ("main");
     if (!f) return false;
-    
+
     IRBuilder<> Builder (f->getContext ());
-    
-    Builder.SetInsertPoint (&f->getEntryBlock (), 
+
+    Builder.SetInsertPoint (&f->getEntryBlock (),
                             f->getEntryBlock ().begin ());
 
+    Constant *initFn = nullptr;
+    if (LowerAggregates)
+    {
+      LLVMContext &ctx = M.getContext ();
+      // -- variadic: ShadowMemDsa merges the calls of one region
+      initFn = M.getOrInsertFunction
+        ("verifier.gv.init",
+         FunctionType::get (Type::getVoidTy (ctx), Type::getInt8PtrTy (ctx), true));
+    }
+
     bool change=false;
     for (GlobalVariable &gv : boost::make_iterator_range (M.global_begin (),
                                                           M.global_end ()))
     {
       if (!gv.hasInitializer ()) continue;
+      // -- nothing reads it
+      if (gv.use_empty ()) continue;
       PointerType *ty = dyn_cast<PointerType> (gv.getType ());
       if (!ty) continue;
       Type *ety = ty->getElementType ();
-      // only deal with scalars for now
-      if (!ety->isIntegerTy ()) continue;
-      
-      IntegerType* ity = cast<IntegerType> (ety);
-      
-      // -- create a store instruction
-      Builder.CreateAlignedStore (gv.getInitializer (), &gv, 
-                                  DL->getABITypeAlignment (ity));
-      change=true;
+
+      if (ety->isIntegerTy ())
+      {
+        // -- create a store instruction
+        Builder.CreateAlignedStore (gv.getInitializer (), &gv,
+                                    DL->getABITypeAlignment (ety));
+        change=true;
+        continue;
+      }
+
+      // -- constant globals (e.g., string literals) are left
+      // -- unconstrained
+      if (!initFn || gv.isConstant ()) continue;
+
+      // -- the initializer is read from gv by the encoding
+      Builder.CreateCall (initFn, Builder.CreateBitCast (&gv, Builder.getInt8PtrTy ()));
+      change = true;
     }
-      
+
+    M.getOrInsertNamedMetadata (LoweredMd);
+
+    if (change)
+      if (ModuleSummary *ms = getAnalysisIfAvailable<ModuleSummary> ())
+        ms->invalidate ();
     return change;
   }
 
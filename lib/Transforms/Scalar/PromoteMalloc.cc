@@ -6,6 +6,7 @@
 #include "boost/range.hpp"
 #include "avy/AvyDebug.h"
 #include "llvm/Support/raw_ostream.h"
+#include "seahorn/Analysis/ModuleSummary.hh"
 
 using namespace llvm;
 
@@ -56,6 +57,10 @@ namespace
       // -- remove all calls to free(). This is too much, but ensures
       // -- that all promoted mallocs() are not free'ed by mistake
       for (auto *I : kill) I->eraseFromParent ();
+
+      if (changed || !kill.empty ())
+        if (auto *ms = getAnalysisIfAvailable<seahorn::ModuleSummary> ())
+          ms->invalidate ();
       
       return changed;
     }
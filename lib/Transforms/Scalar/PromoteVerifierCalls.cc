@@ -10,6 +10,7 @@
 #include "avy/AvyDebug.h"
 
 #include "llvm/Analysis/CallGraph.h"
+#include "seahorn/Analysis/ModuleSummary.hh"
 using namespace llvm;
 
 namespace seahorn
@@ -169,6 +170,10 @@ namespace seahorn
     }
     
     for (auto *I : toKill) I->eraseFromParent ();
+
+    if (!toKill.empty ())
+      if (ModuleSummary *ms = getAnalysisIfAvailable<ModuleSummary> ())
+        ms->invalidate ();
     
     return Changed;
   }
@@ -27,6 +27,7 @@
 #include "llvm/ADT/Statistic.h"
 
 #include "avy/AvyDebug.h"
+#include "seahorn/Analysis/ModuleSummary.hh"
 
 using namespace llvm;
 
@@ -409,6 +410,10 @@ namespace
     bool Changed = !m_worklist.empty ();
     for (auto &I : m_worklist) mkDirectCall (I);
 
+    if (Changed)
+      if (auto *ms = getAnalysisIfAvailable<seahorn::ModuleSummary> ())
+        ms->invalidate ();
+
     // Conservatively assume that we've changed one or more call sites.
     return Changed;
   }
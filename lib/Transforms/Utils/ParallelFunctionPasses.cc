@@ -0,0 +1,207 @@
+#include "seahorn/Transforms/Utils/ParallelFunctionPasses.hh"
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "boost/range.hpp"
+#include "boost/lexical_cast.hpp"
+
+#include <thread>
+#include <algorithm>
+
+#include "avy/AvyDebug.h"
+
+namespace seahorn
+{
+  using namespace llvm;
+
+  namespace
+  {
+    /// the work of one thread
+    struct Part
+    {
+      StringSet<> fns;
+      unsigned size;
+      /// the processed part, as bitcode
+      SmallString<0> out;
+      bool ok;
+
+      Part () : size (0), ok (false) {}
+    };
+
+    void runPasses (Module &M, std::function<void (PassManager&)> &addPasses)
+    {
+      PassManager pm;
+      if (M.getDataLayout ()) pm.add (new DataLayoutPass ());
+      addPasses (pm);
+      pm.run (M);
+    }
+
+    void writeBitcode (const Module &M, SmallString<0> &buf)
+    {
+      raw_svector_ostream os (buf);
+      WriteBitcodeToFile (&M, os);
+      os.flush ();
+    }
+
+    /// reads a copy of the module, keeps the bodies of the functions
+    /// in part, runs the passes, and writes the result back
+    void runPart (StringRef in, Part &part, unsigned id,
+                  std::function<void (PassManager&)> addPasses)
+    {
+      LLVMContext ctx;
+      ErrorOr<Module*> res = parseBitcodeFile (MemoryBufferRef (in, "seapp"), ctx);
+      if (!res) return;
+      std::unique_ptr<Module> M (res.get ());
+
+      // -- everything outside of the part becomes an external
+      // -- declaration so that it links against the original module
+      for (Function &F : *M)
+      {
+        if (F.isDeclaration ()) continue;
+        if (part.fns.count (F.getName ())) F.setLinkage (GlobalValue::ExternalLinkage);
+        else F.deleteBody ();
+      }
+      for (GlobalVariable &gv : boost::make_iterator_range (M->global_begin (),
+                                                            M->global_end ()))
+        // -- initializers stay visible to the passes but are not linked
+        gv.setLinkage (gv.hasInitializer () ?
+                       GlobalValue::AvailableExternallyLinkage :
+                       GlobalValue::ExternalLinkage);
+
+      StringSet<> known;
+      for (GlobalValue &gv : boost::make_iterator_range (M->global_begin (),
+                                                         M->global_end ()))
+        known.insert (gv.getName ());
+      for (Function &F : *M) known.insert (F.getName ());
+
+      runPasses (*M, addPasses);
+
+      // -- declarations added by the passes get a name unique to
+      // -- the part. Intrinsics are the same everywhere
+      std::string sfx = ".p" + boost::lexical_cast<std::string> (id);
+      for (Function &F : *M)
+        if (!known.count (F.getName ()) && !F.isIntrinsic ())
+          F.setName (Twine (F.getName ()) + sfx);
+      for (GlobalVariable &gv : boost::make_iterator_range (M->global_begin (),
+                                                            M->global_end ()))
+        if (!known.count (gv.getName ())) gv.setName (Twine (gv.getName ()) + sfx);
+
+      // -- module-level metadata stays in the original module
+      while (M->named_metadata_begin () != M->named_metadata_end ())
+        M->eraseNamedMetadata (&*M->named_metadata_begin ());
+
+      writeBitcode (*M, part.out);
+      part.ok = true;
+    }
+  }
+
+  bool runFunctionPassesInParallel (Module &M, unsigned jobs,
+                                    std::function<void (PassManager&)> addPasses)
+  {
+    std::vector<std::pair<unsigned, Function*> > defs;
+    for (Function &F : M)
+    {
+      if (F.isDeclaration ()) continue;
+      unsigned sz = 0;
+      for (BasicBlock &bb : F) sz += bb.size ();
+      defs.push_back (std::make_pair (sz, &F));
+    }
+
+    jobs = std::min<unsigned> (jobs, defs.size ());
+    if (jobs <= 1 || !M.alias_empty () || !M.getComdatSymbolTable ().empty ())
+    {
+      runPasses (M, addPasses);
+      return true;
+    }
+
+    // -- every global needs a name to be linked back
+    for (GlobalVariable &gv : boost::make_iterator_range (M.global_begin (),
+                                                          M.global_end ()))
+      if (!gv.hasName ()) gv.setName ("seapp.gv");
+    for (Function &F : M)
+      if (!F.hasName ()) F.setName ("seapp.fn");
+
+    // -- largest functions first, each into the smallest part
+    std::vector<Part> parts (jobs);
+    std::sort (defs.begin (), defs.end (),
+               [] (const std::pair<unsigned, Function*> &a,
+                   const std::pair<unsigned, Function*> &b)
+               { return a.first > b.first; });
+    for (auto &d : defs)
+    {
+      Part &p = *std::min_element (parts.begin (), parts.end (),
+                                   [] (const Part &a, const Part &b)
+                                   { return a.size < b.size; });
+      p.fns.insert (d.second->getName ());
+      p.size += d.first;
+    }
+
+    LOG ("parallel", errs () << "Running function passes on "
+         << defs.size () << " functions in " << jobs << " parts\n";);
+
+    SmallString<0> in;
+    writeBitcode (M, in);
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < jobs; ++i)
+      workers.push_back (std::thread (runPart, in.str (), std::ref (parts [i]),
+                                      i, addPasses));
+    for (std::thread &t : workers) t.join ();
+
+    for (Part &p : parts)
+      if (!p.ok)
+      {
+        errs () << "WARNING: parallel preprocessing failed. "
+                << "Running function passes sequentially.\n";
+        runPasses (M, addPasses);
+        return true;
+      }
+
+    // -- drop the bodies and make everything linkable. Linkage is
+    // -- restored once the parts are linked back
+    StringMap<GlobalValue::LinkageTypes> linkage;
+    for (GlobalVariable &gv : boost::make_iterator_range (M.global_begin (),
+                                                          M.global_end ()))
+    {
+      linkage [gv.getName ()] = gv.getLinkage ();
+      if (gv.hasLocalLinkage ()) gv.setLinkage (GlobalValue::ExternalLinkage);
+    }
+    for (Function &F : M)
+    {
+      linkage [F.getName ()] = F.getLinkage ();
+      if (!F.isDeclaration ()) F.deleteBody ();
+      else if (F.hasLocalLinkage ()) F.setLinkage (GlobalValue::ExternalLinkage);
+    }
+
+    for (Part &p : parts)
+    {
+      ErrorOr<Module*> res =
+        parseBitcodeFile (MemoryBufferRef (p.out.str (), "seapp"), M.getContext ());
+      if (!res)
+      {
+        errs () << "error: could not read a preprocessed part: "
+                << res.getError ().message () << "\n";
+        return false;
+      }
+      std::unique_ptr<Module> src (res.get ());
+      if (Linker::LinkModules (&M, src.get ()))
+      {
+        errs () << "error: could not link a preprocessed part\n";
+        return false;
+      }
+    }
+
+    for (auto &kv : linkage)
+      if (GlobalValue *gv = M.getNamedValue (kv.getKey ()))
+        gv->setLinkage (kv.getValue ());
+
+    return true;
+  }
+}
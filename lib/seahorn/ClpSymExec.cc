@@ -11,6 +11,7 @@
 #include "seahorn/Transforms/Instrumentation/ShadowMemDsa.hh"
 
 #include "ufo/ufo_iterators.hpp"
+#include "ufo/ExprLinear.hpp"
 
 
 using namespace seahorn;
@@ -64,8 +65,7 @@ namespace
     void write (const Value &v, Expr val) 
     { if (m_sem.isTracked (v)) m_s.write (symb (v), val); }
 
-    Expr negate (Expr e)
-    { return op::boolop::nnf (boolop::lneg (e)); }
+    Expr negate (Expr e) { return ClpSmallSymExec::negate (e); }
 
   };
   
@@ -99,26 +99,26 @@ namespace
       switch (I.getPredicate ())
       {
       case CmpInst::ICMP_EQ:
-        res = mk<EQ>(op0,op1); 
+        res = linear::mkEq (op0,op1);
         break;
       case CmpInst::ICMP_NE:
-        res = mk<NEQ>(op0,op1);
+        res = linear::mkNeq (op0,op1);
         break;
       case CmpInst::ICMP_UGT:
       case CmpInst::ICMP_SGT:
-        res = mk<GT>(op0,op1); 
+        res = linear::mkGt (op0,op1);
         break;
       case CmpInst::ICMP_UGE:
       case CmpInst::ICMP_SGE:
-        res = mk<GEQ>(op0,op1);
+        res = linear::mkGeq (op0,op1);
         break;
       case CmpInst::ICMP_ULT:
       case CmpInst::ICMP_SLT:        
-        res = mk<LT>(op0,op1); 
+        res = linear::mkLt (op0,op1);
         break; 
       case CmpInst::ICMP_ULE:
       case CmpInst::ICMP_SLE:
-        res = mk<LEQ>(op0,op1);
+        res = linear::mkLeq (op0,op1);
         break;
       default:
         break;
@@ -219,7 +219,7 @@ namespace
       mpz_class factor = 1;
       for (unsigned long i = 0; i < shift.get_ui (); ++i) 
       { factor = factor * 2; }
-      Expr res = mk<MULT>(op1, mkTerm<mpz_class> (factor, m_efac));        
+      Expr res = linear::mkMult (op1, mkTerm<mpz_class> (factor, m_efac));
       return res;
     }
 
@@ -238,13 +238,13 @@ namespace
       switch(i.getOpcode())
       {
         case BinaryOperator::Add:          
-          res = mk<PLUS>(op1, op2); 
+          res = linear::mkPlus (op1, op2);
           break;
         case BinaryOperator::Sub:          
-          res = mk<MINUS>(op1, op2);
+          res = linear::mkMinus (op1, op2);
           break;
         case BinaryOperator::Mul:          
-          res = mk<MULT>(op1, op2); 
+          res = linear::mkMult (op1, op2);
           break;
         case BinaryOperator::SDiv:
         case BinaryOperator::UDiv:          
@@ -265,7 +265,8 @@ namespace
     void visitReturnInst (ReturnInst &I)
     {
       // -- skip return argument of main
-      if (I.getParent ()->getParent ()->getName ().equals ("main")) return;
+      if (m_sem.intrinsicKind (*I.getParent ()->getParent ()) == intrinsic::MAIN)
+        return;
       
       if (I.getNumOperands () > 0)
         lookup (*I.getOperand (0));
@@ -336,159 +337,13 @@ namespace
       { write (I, op0); }
     }
     
-    void visitCallSite (CallSite CS)
-    {
-      assert (CS.isCall ());
-      const Function *f = CS.getCalledFunction ();
-      
-      Instruction &I = *CS.getInstruction ();
-      BasicBlock &BB = *I.getParent ();
-      
-      // -- unknown/indirect function call
-      if (!f)
-      { 
-        // XXX Use DSA and/or Devirt to handle better
-        assert (m_fparams.size () == 3);
-        visitInstruction (I);
-        return;
-      }
-      
-      const Function &F = *f;
-      const Function &PF = *I.getParent ()->getParent ();
-      
-      // skip intrinsic functions
-      if (F.isIntrinsic ()) { assert (m_fparams.size () == 3); return;}
+    void visitCallSite (CallSite CS) { m_sem.execCallSite (*this, CS); }
     
-      
-      if (F.getName ().equals ("verifier.assume"))
-      {
-        assert (m_fparams.size () == 3);
-        // -- assumption is only active when error flag is false
-        m_side.push_back (boolop::lor (m_s.read (m_sem.errorFlag (BB)),
-                                       lookup (*CS.getArgument (0))));
-      }
-      // else if (F.getName ().equals ("verifier.assert"))
-      // {
-      //   Expr ein = m_s.read (m_sem.errorFlag ());
-      //   Expr eout = m_s.havoc (m_sem.errorFlag ());
-      //   Expr cond = lookup (*CS.getArgument (0));
-      //   m_side.push_back (boolop::limp (cond,
-      //                                   mk<EQ> (ein, eout)));
-      //   m_side.push_back (boolop::limp (boolop::lneg (cond), eout));
-      // }
-      // else if (F.getName ().equals ("verifier.error"))
-      //   m_side.push_back (m_s.havoc (m_sem.errorFlag ()));
-      else if (F.getName ().equals ("verifier.assume.not"))
-      {
-        assert (m_fparams.size () == 3);
-        m_side.push_back (boolop::lor (m_s.read (m_sem.errorFlag (BB)), 
-                                       boolop::lneg (lookup (*CS.getArgument (0)))));
-      }
-      else if (m_sem.hasFunctionInfo (F))
-      {
-        const FunctionInfo &fi = m_sem.getFunctionInfo (F);
-        
-        // enabled
-        m_fparams [0] = trueE;
-        // error flag in
-        m_fparams [1] = (m_s.read (m_sem.errorFlag (BB)));
-        // error flag out
-        m_fparams [2] = (m_s.havoc (m_sem.errorFlag (BB)));
-        for (const Argument *arg : fi.args)
-          m_fparams.push_back (m_s.read (symb (*CS.getArgument (arg->getArgNo ()))));
-        for (const GlobalVariable *gv : fi.globals)
-          m_fparams.push_back (m_s.read (symb (*gv)));
-        
-        if (fi.ret) m_fparams.push_back (m_s.havoc (symb (I)));
-        
-        LOG ("arg_error", 
-             if (m_fparams.size () != bind::domainSz (fi.sumPred))
-             {
-               errs () << "Call instruction: " << I << "\n";
-               errs () << "Caller: " << PF << "\n";
-               errs () << "Callee: " << F << "\n";
-               // errs () << "Sum predicate: " << *fi.sumPred << "\n";
-               errs () << "m_fparams.size: " << m_fparams.size () << "\n";
-               errs () << "Domain size: " << bind::domainSz (fi.sumPred) << "\n";
-               errs () << "m_fparams\n";
-               for (auto r : m_fparams) errs () << *r << "\n";
-               errs () << "regions: " << fi.regions.size () 
-                       << " args: " << fi.args.size () 
-                       << " globals: " << fi.globals.size () 
-                       << " ret: " << fi.ret << "\n";
-               errs () << "regions\n";
-               for (auto r : fi.regions) errs () << *r << "\n";
-               errs () << "args\n";
-               for (auto r : fi.args) errs () << *r << "\n";
-               errs () << "globals\n";
-               for (auto r : fi.globals) errs () << *r << "\n";
-               if (fi.ret) errs () << "ret: " << *fi.ret << "\n";
-             }
-             );
-        
-        assert (m_fparams.size () == bind::domainSz (fi.sumPred));
-        m_side.push_back (bind::fapp (fi.sumPred, m_fparams));
-        
-        m_fparams.clear ();
-        m_fparams.push_back (falseE);
-        m_fparams.push_back (falseE);
-        m_fparams.push_back (falseE);
-      }
-      else if (F.getName ().startswith ("shadow.mem") && 
-               m_sem.isTracked (I))
-      {
-        if (F.getName ().equals ("shadow.mem.init"))
-          m_s.havoc (symb(I));
-        else if (F.getName ().equals ("shadow.mem.load"))
-        {
-          const Value &v = *CS.getArgument (1);
-          m_inMem = m_s.read (symb (v));
-        }
-        else if (F.getName ().equals ("shadow.mem.store"))
-        {
-          m_inMem = m_s.read (symb (*CS.getArgument (1)));
-          m_outMem = m_s.havoc (symb (I));
-        }
-        else if (F.getName ().equals ("shadow.mem.arg.ref"))
-          m_fparams.push_back (m_s.read (symb (*CS.getArgument (1))));
-        else if (F.getName ().equals ("shadow.mem.arg.mod"))
-        {
-          m_fparams.push_back (m_s.read (symb (*CS.getArgument (1))));
-          m_fparams.push_back (m_s.havoc (symb (I)));
-        }
-        else if (F.getName ().equals ("shadow.mem.arg.new"))
-          m_fparams.push_back (m_s.havoc (symb (I)));
-        else if (!PF.getName ().equals ("main") && 
-                 F.getName ().equals ("shadow.mem.in"))
-        {
-          m_s.read (symb (*CS.getArgument (1)));
-        }
-        else if (!PF.getName ().equals ("main") &&
-                 F.getName ().equals ("shadow.mem.out"))
-        {
-          m_s.read (symb (*CS.getArgument (1)));
-        }
-        else if (!PF.getName ().equals ("main") && 
-                 F.getName ().equals ("shadow.mem.arg.init"))
-        {
-          // regions initialized in main are global. We want them to
-          // flow to the arguments
-          /* do nothing */
-        }
-      }
-      else
-      {
-        if (m_fparams.size () > 3)
-        {
-          m_fparams.resize (3);
-          errs () << "WARNING: skipping a call to " << F.getName () 
-                  << " (recursive call?)\n";
-        }
-        
-        visitInstruction (*CS.getInstruction ());
-      }
-          
-    }
+    /// -- hooks of SmallSymExecCore::execCallSite. Constraints are
+    /// -- never guarded and there are no special intrinsics
+    Expr activeLit () { return trueE; }
+    bool execIntrinsic (CallSite CS, intrinsic::Kind kind) { return false; }
+    void shadowMemAccess (CallSite CS, intrinsic::Kind kind) {}
     
     void visitLoadInst (LoadInst &I)
     {
@@ -545,7 +400,7 @@ namespace
     {
       const Function &F = *BB.getParent ();
       if (&F.getEntryBlock () != &BB) return;
-      if (!F.getName ().equals ("main")) return;
+      if (m_sem.intrinsicKind (F) != intrinsic::MAIN) return;
       
       const Module &M = *F.getParent ();
       for (const GlobalVariable &g : boost::make_iterator_range (M.global_begin (),
@@ -573,32 +428,27 @@ namespace
                        ExprVector &side, const BasicBlock &dst) : 
       SymExecBase (s, sem, side), m_dst (dst) {}
     
-    void visitPHINode (PHINode &I) 
-    {
-      if (!m_sem.isTracked (I)) return;
-      
-      const Value &v = *I.getIncomingValueForBlock (&m_dst);
-
-      Expr op0 = lookup (v);
-      // -- phi node can read and write the same register. Thus, we
-      // -- must first lookup the value of the argument, and only then
-      // -- havoc the register.
-      Expr lhs = havoc (I);
-      write (I, op0);
-    }
+    void visitBasicBlock (BasicBlock &BB) { m_sem.execPhis (*this, BB, m_dst); }
+    
+    /// -- hook of SmallSymExecCore::execPhis
+    void definePhi (PHINode &phi, Expr lhs, Expr val)
+    { if (val) write (phi, val); }
 
   };
 }
 
 namespace seahorn
 {
-  Expr ClpSmallSymExec::errorFlag (const BasicBlock &BB)
+  bool ClpSmallSymExec::shadowMem (const Value &v, const Value **scalar)
   {
-    // -- if BB belongs to a function that cannot fail, errorFlag is always false
-    if (m_canFail && !m_canFail->canFail (BB.getParent ())) return falseE;
-    return this->SmallStepSymExec::errorFlag (BB);
+    // -- memory regions of a single scalar are not tracked as registers
+    const Value *sc;
+    return shadow_dsa::isShadowMem (v, &sc);
   }
   
+  Expr ClpSmallSymExec::negate (Expr e)
+  { return op::boolop::nnf (boolop::lneg (e)); }
+  
   void ClpSmallSymExec::exec (SymStore &s, const BasicBlock &bb, ExprVector &side,
                               Expr act)
   {
@@ -622,179 +472,4 @@ namespace seahorn
     v.visit (const_cast<BasicBlock&>(bb));
   }
 
-  Expr ClpSmallSymExec::ptrArith (SymStore &s, 
-                                  const Value &base,
-                                  SmallVectorImpl<const Value*> &ps,
-                                  SmallVectorImpl<const Type*> &ts)
-  {
-    Expr res = lookup (s, base);
-    if (!res) return res;
-    
-    for (unsigned i = 0; i < ps.size (); ++i)
-    {
-      if (const StructType *st = dyn_cast<const StructType> (ts [i]))
-      {
-        if (const ConstantInt *ci = dyn_cast<const ConstantInt> (ps [i]))
-        {
-          Expr off = mkTerm<mpz_class> (fieldOff (st, ci->getZExtValue ()), m_efac);
-          res = mk<PLUS> (res, off);
-        }
-        else assert (0);
-      }
-      else if (const SequentialType *seqt = dyn_cast<const SequentialType> (ts [i]))
-      {
-        Expr sz = mkTerm<mpz_class> (storageSize (seqt->getElementType ()), m_efac);
-        res = mk<PLUS> (res, mk<MULT> (lookup (s, *ps[i]), sz));
-      }
-    }
-    return res;
-  }
-  
-  unsigned ClpSmallSymExec::storageSize (const llvm::Type *t) 
-  {return m_td->getTypeStoreSize (const_cast<Type*> (t));}
-  
-  unsigned ClpSmallSymExec::fieldOff (const StructType *t, unsigned field)
-  {
-    return m_td->getStructLayout (const_cast<StructType*>(t))->getElementOffset (field);
-  }
-    
-  Expr ClpSmallSymExec::symb (const Value &I)
-  {
-    // -- basic blocks are mapped to Bool constants
-    if (const BasicBlock *bb = dyn_cast<const BasicBlock> (&I))
-      return bind::boolConst 
-        (mkTerm<const BasicBlock*> (bb, m_efac));
-    
-    // -- constants are mapped to values
-    if (const Constant *cv = dyn_cast<const Constant> (&I))
-    {
-      if (const ConstantInt *c = dyn_cast<const ConstantInt> (&I))
-      {
-        if (c->getType ()->isIntegerTy (1))
-          return c->isOne () ? trueE : falseE;
-        mpz_class k = toMpz (c->getValue ());
-        return mkTerm<mpz_class> (k, m_efac);
-      }
-      else if (cv->isNullValue () || isa<ConstantPointerNull> (&I))
-        return mkTerm<mpz_class> (0, m_efac);
-      else if (const ConstantExpr *ce = dyn_cast<const ConstantExpr> (&I))
-      {
-        // -- if this is a cast, and not into a Boolean, strip it
-        // -- XXX handle Boolean casts if needed
-        if (ce->isCast () && 
-            (ce->getType ()->isIntegerTy () || ce->getType ()->isPointerTy ()) && 
-            ! ce->getType ()->isIntegerTy (1))
-   
-        {
-          if (const ConstantInt* val = dyn_cast<const ConstantInt>(ce->getOperand (0)))
-          {
-            mpz_class k = toMpz (val->getValue ());
-            return mkTerm<mpz_class> (k, m_efac);
-          }
-          // -- strip cast
-          else return symb (*ce->getOperand (0));
-        }
-      }
-    }   
-     
-    // -- everything else is mapped to a constant
-    Expr v = mkTerm<const Value*> (&I, m_efac);
-    
-    const Value *scalar = nullptr;
-    if (m_trackLvl >= MEM && shadow_dsa::isShadowMem (I, &scalar))
-    {
-      Expr intTy = sort::intTy (m_efac);
-      Expr ty = sort::arrayTy (intTy, intTy);
-      return bind::mkConst (v, ty);
-    }
-
-    if (isTracked (I))
-    {
-      if (I.getType ()->isIntegerTy (1))
-        return bind::boolConst (v); 
-      else
-        return bind::intConst (v);
-    }
-    
-    return Expr(0);
-  }
-  
-  const Value &ClpSmallSymExec::conc (Expr v)
-  {
-    assert (isOpX<FAPP> (v));
-    // name of the app
-    Expr u = bind::fname (v);
-    // name of the fdecl
-    u = bind::fname (u);
-    assert (isOpX<VALUE> (v));
-    return *getTerm<const Value*> (v);
-  }
-  
-  
-  bool ClpSmallSymExec::isTracked (const Value &v) 
-  {
-    const Value* scalar;
-
-    // -- shadow values represent memory regions
-    // -- only track them when memory is tracked
-    if (shadow_dsa::isShadowMem (v, &scalar)) return m_trackLvl >= MEM;
-    // -- a pointer
-    if (v.getType ()->isPointerTy ()) return m_trackLvl >= PTR;
-    
-    // -- always track integer registers
-    return v.getType ()->isIntegerTy ();
-  }
-  
-  Expr ClpSmallSymExec::lookup (SymStore &s, const Value &v)
-  {
-    Expr u = symb (v);
-    // if u is defined it is either an fapp or a constant
-    if (u) return bind::isFapp (u) ? s.read (u) : u;
-    return Expr (0);
-  }
-
-  void ClpSmallSymExec::execEdg (SymStore &s, const BasicBlock &src,
-                                 const BasicBlock &dst, ExprVector &side)
-  {
-    Expr trueE = mk<TRUE> (m_efac);
-    exec (s, src, side, trueE);
-    execBr (s, src, dst, side, trueE);
-    execPhi (s, dst, src, side, trueE);
-    
-    // an edge into a basic block that does not return includes the block itself
-    const TerminatorInst *term = dst.getTerminator ();
-    if (term && isa<const UnreachableInst> (term)) exec (s, dst, side, trueE);
-
-  }
-  
-  void ClpSmallSymExec::execBr (SymStore &s, const BasicBlock &src, const BasicBlock &dst, 
-                                ExprVector &side, Expr act)
-  {
-    assert (isOpX<TRUE> (act));
-    // the branch condition
-    if (const BranchInst *br = dyn_cast<const BranchInst> (src.getTerminator ()))
-    {
-      if (br->isConditional ())
-      {
-        const Value &c = *br->getCondition ();
-        if (const ConstantInt *ci = dyn_cast<const ConstantInt> (&c))
-        {
-          if ((ci->isOne () && br->getSuccessor (0) != &dst) ||
-              (ci->isZero () && br->getSuccessor (1) != &dst))
-          {
-            side.clear ();
-            side.push_back (s.read (errorFlag (src)));
-          }
-        }
-        else if (Expr target = lookup (s, c))
-        {          
-          SymExecBase sym (s, *this, side); 
-          Expr cond = br->getSuccessor (0) == &dst ? target : sym.negate (target);
-          cond = boolop::lor (s.read (errorFlag (src)), cond);
-          side.push_back (cond);
-        }
-      }
-    }   
-  }
-      
 }
@@ -289,7 +289,7 @@ namespace seahorn
           ExprVector side;
           side.push_back (boolop::lneg ((s.read (m_sem.errorFlag (cp.bb ())))));
           lsem.execCpEdg (s, *edge, side);
-          Expr tau = mknary<AND> (mk<TRUE> (m_efac), side);
+          Expr tau = lsem.conjoin (side);
           expr::filter (tau, bind::IsConst(), 
                         std::inserter (allVars, allVars.begin ()));
 
@@ -9,12 +9,14 @@
 #include "seahorn/HornSolver.hh"
 #include "seahorn/Analysis/CutPointGraph.hh"
 #include "seahorn/Analysis/CanFail.hh"
+#include "seahorn/Support/CFG.hh"
 
 #include "boost/range.hpp"
 #include "boost/range/adaptor/reversed.hpp"
 #include "boost/range/algorithm/sort.hpp"
 #include "boost/container/flat_set.hpp"
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ToolOutputFile.h"
@@ -43,6 +45,24 @@ SvCompCexFileArch("horn-svcomp-cex-arch",
                   llvm::cl::desc("Architecture key in SV-COMP XML format"),
                   llvm::cl::init("32bit"));
 
+static llvm::cl::opt<bool>
+GroundCex ("horn-cex-ground",
+           llvm::cl::desc ("Build the counterexample, its values and the "
+                           "harness from the ground answer of the Horn solver "
+                           "instead of re-solving the trace"),
+           llvm::cl::init (false));
+
+static llvm::cl::opt<bool>
+ValidateCex ("horn-cex-validate",
+             llvm::cl::desc ("Validate a ground counterexample by re-solving "
+                             "the whole trace"),
+             llvm::cl::init (false));
+
+static llvm::cl::opt<std::string>
+HornCexHarness ("horn-cex-harness",
+                llvm::cl::desc ("Write a C harness that replays the counterexample"),
+                llvm::cl::init (""), llvm::cl::value_desc ("filename"));
+
 static llvm::cl::opt<std::string>
 HornCexSmtFilename("horn-cex-smt", llvm::cl::desc("Counterexample validate SMT problem"),
                llvm::cl::init(""), llvm::cl::value_desc("filename"), llvm::cl::Hidden);
@@ -62,6 +82,10 @@ namespace seahorn
     
     errs () << "In simplify\n";
     
+    // -- the memo table is shared until side changes
+    Substitution sub (efac, side, true);
+    auto learn = [&] (Expr k, Expr v) { side [k] = v; sub.add (k, v); };
+    
     while (changed)
     {
       changed = false;
@@ -71,7 +95,7 @@ namespace seahorn
         
         if (isOpX<TRUE> (v)) continue;
         
-        Expr u = replaceSimplify (v, side);
+        Expr u = sub (v);
         assert (u.get ());
         if (u != v) 
         {
@@ -90,20 +114,20 @@ namespace seahorn
         }
         else if (bind::isBoolConst (v))
         {
-          side[v] = trueE;
+          learn (v, trueE);
           v = trueE;
           changed = true;
         }
         else if (isOpX<NEG> (v) && bind::isBoolConst (v->arg (0)))
         {
-          side [v->arg (0)] = falseE;
+          learn (v->arg (0), falseE);
           v = trueE;
           changed = true;
         }
         else if (isOpX<EQ> (v) || isOpX<IFF> (v))
         {
           if (v-> arg (0) != v->arg (1))
-            side [v->arg (0)] = v->arg (1);
+            learn (v->arg (0), v->arg (1));
           v = trueE;
           changed = true;
         }
@@ -340,6 +364,170 @@ namespace seahorn
     out.keep ();
   }
   
+  /// Computes an implicant of the side constraints in the model and
+  /// stores it in a lookup table
+  template <typename Model>
+  static void computeImplicant (const ExprVector &side, Model &mdl,
+                                boost::container::flat_set<Expr> &implicant)
+  {
+    ExprVector trace;
+    trace.reserve (side.size ());
+    
+    for (auto v : side)
+    {
+      // -- break IMPL into an OR
+      // -- OR into a single disjunct
+      // -- single disjunct into an AND
+      if (isOpX<IMPL> (v))
+      {
+        Expr a0 = mdl (v->arg (0));
+        if (isOpX<FALSE> (a0)) continue;
+        else if (isOpX<TRUE> (a0))
+          v = mknary<OR> (mk<FALSE> (v->efac ()), 
+                          ++(v->args_begin ()), v->args_end ());
+        else
+          continue;
+      }
+      
+      if (isOpX<OR> (v))
+      {
+        for (unsigned i = 0; i < v->arity (); ++i)
+          if (isOpX<TRUE> (mdl (v->arg (i))))
+          {
+            v = v->arg (i);
+            break;
+          }
+      }
+        
+      if (isOpX<AND> (v)) 
+      {
+        for (unsigned i = 0; i < v->arity (); ++i)
+          trace.push_back (v->arg (i));
+      }
+      else trace.push_back (v);
+    }
+    
+    boost::sort (trace);
+    implicant.insert (trace.begin (), trace.end ());
+  }
+
+  typedef HornCex::NondetValues NondetValues;
+  
+  static bool isNondetFn (const Function *fn)
+  {return fn && fn->getName ().startswith ("__VERIFIER_nondet_");}
+
+  /// C type of the values returned by a nondet function
+  static std::string harnessType (const Type *ty)
+  {
+    if (ty->isIntegerTy (1)) return "_Bool";
+    if (ty->isIntegerTy (8)) return "char";
+    if (ty->isIntegerTy (16)) return "short";
+    if (ty->isIntegerTy (32)) return "int";
+    if (ty->isIntegerTy (64)) return "long long";
+    if (ty->isPointerTy ()) return "void*";
+    return "";
+  }
+  
+  /// the value v as a C literal, or the empty string if the
+  /// counterexample does not determine it
+  static std::string harnessValue (Expr v)
+  {
+    // -- not tracked by the symbolic execution
+    if (!v) return "";
+    if (isOpX<TRUE> (v)) return "1";
+    if (isOpX<FALSE> (v)) return "0";
+    if (isOpX<MPZ> (v))
+      return boost::lexical_cast<std::string> (getTerm<mpz_class> (v));
+    // -- not constrained by the model
+    return "";
+  }
+  
+  /// a function other than main that calls a nondet function, if any
+  static const Function *nondetCaller (const Function &main)
+  {
+    for (const Function &fn : *main.getParent ())
+    {
+      if (!isNondetFn (&fn)) continue;
+      for (const User *u : fn.users ())
+        if (const Instruction *I = dyn_cast<Instruction> (u))
+          if (I->getParent ()->getParent () != &main)
+            return I->getParent ()->getParent ();
+    }
+    return nullptr;
+  }
+  
+  /// Writes a C file that defines every nondet function to return
+  /// the values of the counterexample in call order. Linked with the
+  /// original program, it replays the counterexample natively.
+  /// Values the counterexample does not determine are replaced by 0
+  /// and marked in the file, and a warning is printed.
+  ///
+  /// Only the calls in main are recorded. If another function calls
+  /// a nondet function, its values would be missing from the call
+  /// order, so no harness is written.
+  static void printHarness (const NondetValues &values, const Function &main)
+  {
+    if (HornCexHarness.empty ()) return;
+
+    if (const Function *caller = nondetCaller (main))
+    {
+      errs () << "Warning: " << caller->getName ()
+              << " calls a nondet function and is not inlined into main. "
+              << "No harness is written; run with --horn-inline-all\n";
+      return;
+    }
+    
+    std::error_code ec;
+    llvm::tool_output_file out (HornCexHarness.c_str (), ec, llvm::sys::fs::F_Text);
+    if (ec)
+    {
+      errs () << "ERROR: Cannot open harness file: " << ec.message () << "\n";
+      return;
+    }
+
+    raw_ostream &os = out.os ();
+    os << "/* counterexample harness generated by SeaHorn */\n";
+    for (auto &kv : values)
+    {
+      const Function *fn = kv.first;
+      const ExprVector &vals = kv.second;
+      std::string ty = harnessType (fn->getReturnType ());
+      if (ty.empty ())
+      {
+        errs () << "Warning: no harness for " << fn->getName () << "\n";
+        continue;
+      }
+      
+      os << "\n" << ty << " " << fn->getName () << " (void)\n{\n";
+      os << "  static const " << ty << " vals [] = {";
+      unsigned guessed = 0;
+      for (unsigned i = 0; i < vals.size (); ++i)
+      {
+        std::string v = harnessValue (vals [i]);
+        os << (i > 0 ? ", " : "") << "(" << ty << ")";
+        if (v.empty ())
+        {
+          // -- untracked, or unconstrained by the model
+          os << "0 /* guessed */";
+          ++guessed;
+        }
+        else os << v;
+      }
+      // -- an empty initializer is not valid C
+      if (vals.empty ()) os << "0 /* guessed */";
+      os << "};\n";
+      os << "  static unsigned idx = 0;\n";
+      os << "  /* calls past the counterexample are guessed: they repeat vals [0] */\n";
+      os << "  return idx < " << vals.size () << " ? vals [idx++] : vals [0];\n";
+      os << "}\n";
+      
+      if (guessed > 0)
+        errs () << "Warning: harness guesses " << guessed << " of " << vals.size ()
+                << " values of " << fn->getName () << "\n";
+    }
+    out.keep ();
+  }
+
   static bool isVoidFn (const llvm::Instruction &I)
   {
     if (const CallInst *ci = dyn_cast<const CallInst> (&I))
@@ -348,6 +536,38 @@ namespace seahorn
     
     return false;
   }
+
+  /// records the values returned by the nondet calls of BB. s is the
+  /// state BB was executed in, if any, and mdl a model of it
+  template <typename Model>
+  static void recordNondet (NondetValues &nondet, const BasicBlock &BB,
+                            UfoSmallSymExec &sem, SymStore *s, Model &mdl)
+  {
+    for (auto &I : BB)
+      if (const CallInst *ci = dyn_cast<const CallInst> (&I))
+        if (isNondetFn (ci->getCalledFunction ()))
+        {
+          ExprVector &vals = nondet [ci->getCalledFunction ()];
+          if (s && sem.isTracked (I))
+            vals.push_back (mdl.eval (s->eval (sem.symb (I)), true));
+          else
+            vals.push_back (Expr ());
+        }
+  }
+
+  /// prints the values of the instructions of BB in the state s
+  template <typename Model>
+  static void logValues (const BasicBlock &BB, UfoSmallSymExec &sem,
+                         SymStore &s, Model &mdl)
+  {
+    errs () << BB.getName () << ": \n";
+    for (auto &I : BB)
+    {
+      if (!sem.isTracked (I) || isVoidFn (I)) continue;
+      errs () << "  %" << I.getName () << " "
+              << *mdl.eval (s.eval (sem.symb (I))) << "\n";
+    }
+  }
   
   bool HornCex::runOnFunction (Function &F)
   {
@@ -427,6 +647,26 @@ namespace seahorn
          errs () << "TRACE END\n";);
     
     
+    NondetValues nondet;
+    bool grounded = false;
+    if (GroundCex)
+    {
+      std::vector<const BasicBlock*> cex;
+      grounded = groundCex (F, bbTrace, cex, nondet);
+      if (grounded)
+      {
+        printLineCex (cex);
+        printHarness (nondet, F);
+        // -- re-solving the whole trace only validates the result
+        if (!ValidateCex) return false;
+      }
+      else
+      {
+        errs () << "Warning: no ground counterexample, re-solving the trace\n";
+        nondet.clear ();
+      }
+    }
+    
     ExprFactory &efac = hm.getExprFactory ();
     
     // -- local symbolic execution engine.
@@ -457,7 +697,7 @@ namespace seahorn
     
     
     ZSolver<EZ3> solver (hm.getZContext ());
-    for (Expr v : side) solver.assertExpr (v);
+    solver.assertExpr (lsem.conjoin (side));
     
     if (!HornCexSmtFilename.empty ())
     {
@@ -554,48 +794,8 @@ namespace seahorn
     }
     
     auto mdl (solver.getModel ());
-    ExprVector trace;
-    trace.reserve (side.size ());
-    
-    // compute implicant
-    for (auto v : side)
-    {
-      // -- break IMPL into an OR
-      // -- OR into a single disjunct
-      // -- single disjunct into an AND
-      if (isOpX<IMPL> (v))
-      {
-        Expr a0 = mdl (v->arg (0));
-        if (isOpX<FALSE> (a0)) continue;
-        else if (isOpX<TRUE> (a0))
-          v = mknary<OR> (mk<FALSE> (efac), 
-                          ++(v->args_begin ()), v->args_end ());
-        else
-          continue;
-      }
-      
-      if (isOpX<OR> (v))
-      {
-        for (unsigned i = 0; i < v->arity (); ++i)
-          if (isOpX<TRUE> (mdl (v->arg (i))))
-          {
-            v = v->arg (i);
-            break;
-          }
-      }
-        
-      if (isOpX<AND> (v)) 
-      {
-        for (unsigned i = 0; i < v->arity (); ++i)
-          trace.push_back (v->arg (i));
-      }
-      else trace.push_back (v);
-    }
-    
-    
-    // lookup table for the implicant
-    boost::sort (trace);
-    boost::container::flat_set<Expr> implicant (trace.begin (), trace.end ());
+    boost::container::flat_set<Expr> implicant;
+    computeImplicant (side, mdl, implicant);
     
     std::vector<const BasicBlock*> cex;
     
@@ -686,19 +886,37 @@ namespace seahorn
                }
                errs () << "\n";
              });
+        
+        if (!grounded) recordNondet (nondet, BB, sem, &s, mdl);
         cex.push_back (&BB);
       }
     }
     
     if (edges.empty ())
+    {
       // -- special case when the problem is trivial 
       // -- the entry block contains the error location
+      if (!grounded) recordNondet (nondet, F.getEntryBlock (), sem, nullptr, mdl);
       cex.push_back (&F.getEntryBlock ());
+    }
     else
-      // -- last bb of the last edge
-      cex.push_back (&edges.back ()->target ().bb ());
+    {
+      // -- last bb of the last edge. Its instructions are only
+      // -- executed by the edge if the block does not return
+      const BasicBlock &BB = edges.back ()->target ().bb ();
+      const TerminatorInst *term = BB.getTerminator ();
+      if (!grounded)
+        recordNondet (nondet, BB, sem,
+                      term && isa<UnreachableInst> (term) ? &states.back () : nullptr,
+                      mdl);
+      cex.push_back (&BB);
+    }
+
+    // -- a validated ground counterexample is already printed
+    if (grounded) return false;
     
     printLineCex (cex);
+    printHarness (nondet, F);
     
     // at this point, vector cex contains the counterexample is the
     //proper order. Can construct the necessary XML out of this.
@@ -707,6 +925,152 @@ namespace seahorn
     return false;
   }
   
+  /// Builds the counterexample from the ground answer of the Horn
+  /// solver. The answer has a ground instance of every predicate on
+  /// the trace, so the values at every block of bbTrace are known.
+  /// Each step between consecutive blocks is solved on its own, with
+  /// both of its ends fixed to their ground values: a CFG edge if
+  /// the blocks are successors, and a cut-point edge otherwise. The
+  /// model of each step gives the blocks in between, the values of
+  /// their instructions (the "cex" log) and the values returned by
+  /// nondet calls (the harness).
+  bool HornCex::groundCex (Function &F,
+                           const std::vector<const BasicBlock*> &bbTrace,
+                           std::vector<const BasicBlock*> &cex,
+                           NondetValues &nondet)
+  {
+    HornSolver &hs = getAnalysis<HornSolver> ();
+    HornifyModule &hm = getAnalysis<HornifyModule> ();
+    CutPointGraph &cpg = getAnalysis<CutPointGraph> (F);
+    ExprFactory &efac = hm.getExprFactory ();
+
+    Expr answer = hs.getZFixedPoint ().getGroundSatAnswer ();
+    if (!answer) return false;
+    
+    ExprVector facts;
+    if (isOpX<AND> (answer))
+      facts.assign (answer->args_begin (), answer->args_end ());
+    else
+      facts.push_back (answer);
+
+    // -- ground facts of the basic blocks of F, except its entry
+    std::vector<std::pair<const BasicBlock*, Expr> > ground;
+    for (Expr f : facts)
+    {
+      if (!bind::isFapp (f) || !hm.isBbPredicate (f)) continue;
+      const BasicBlock *bb = &hm.predicateBb (f);
+      if (bb->getParent () != &F || bb == &F.getEntryBlock ()) continue;
+      ground.push_back (std::make_pair (bb, f));
+    }
+
+    // -- the facts must follow the trace, in either direction
+    auto sameTrace = [&] ()
+      {
+        if (ground.size () != bbTrace.size ()) return false;
+        for (unsigned i = 0; i < ground.size (); ++i)
+          if (ground [i].first != bbTrace [i]) return false;
+        return true;
+      };
+    if (!sameTrace ())
+    {
+      boost::reverse (ground);
+      if (!sameTrace ()) return false;
+    }
+    // -- the error is in the entry block. Nothing to solve, and the
+    // -- re-solved trace handles this case
+    if (ground.empty ()) return false;
+
+    LOG ("cex",
+         for (auto &g : ground)
+         {
+           errs () << g.first->getName () << ": \n";
+           const ExprVector &live = hm.live (*g.first);
+           for (unsigned i = 0; i < live.size (); ++i)
+             errs () << "  " << *live [i] << " " << *g.second->arg (i + 1) << "\n";
+         });
+
+    UfoSmallSymExec sem (efac, *this, MEM);
+    UfoLargeSymExec lsem (sem);
+    ZSolver<EZ3> solver (hm.getZContext ());
+    
+    const BasicBlock *prev = &F.getEntryBlock ();
+    Expr prevFact;
+    cex.push_back (prev);
+    for (unsigned k = 0; k < ground.size (); ++k)
+    {
+      const BasicBlock *bb = ground [k].first;
+      Expr fact = ground [k].second;
+      bool isSucc = false;
+      for (const BasicBlock *s : succs (*prev)) isSucc |= (s == bb);
+
+      const CpEdge *edge = nullptr;
+      if (!isSucc)
+      {
+        if (!cpg.isCutPoint (*prev) || !cpg.isCutPoint (*bb)) return false;
+        edge = cpg.getEdge (cpg.getCp2 (*prev), cpg.getCp2 (*bb));
+        if (!edge) return false;
+      }
+      
+      // -- execute the step from the ground values of its source
+      SymStore s (efac);
+      ExprVector side;
+      if (prevFact)
+      {
+        const ExprVector &live = hm.live (*prev);
+        for (unsigned i = 0; i < live.size (); ++i)
+          s.write (live [i], prevFact->arg (i + 1));
+      }
+      if (edge) lsem.execCpEdg (s, *edge, side);
+      else sem.execEdg (s, *prev, *bb, side);
+      
+      // -- and fix its destination to the ground values
+      const ExprVector &live = hm.live (*bb);
+      for (unsigned i = 0; i < live.size (); ++i)
+        side.push_back (mk<EQ> (s.read (live [i]), fact->arg (i + 1)));
+
+      solver.reset ();
+      for (Expr v : side) solver.assertExpr (v);
+      auto res = solver.solve ();
+      if (res) ; else return false;
+      
+      auto mdl (solver.getModel ());
+
+      // -- the source is executed by the step
+      LOG ("cex", logValues (*prev, sem, s, mdl););
+      recordNondet (nondet, *prev, sem, &s, mdl);
+
+      if (edge)
+      {
+        boost::container::flat_set<Expr> implicant;
+        computeImplicant (side, mdl, implicant);
+        
+        for (auto it = ++edge->begin (), end = edge->end (); it != end; ++it)
+        {
+          const BasicBlock &BB = *it;
+          if (&BB == bb) continue;
+          if (implicant.count (s.eval (sem.symb (BB))) <= 0) continue;
+          LOG ("cex", logValues (BB, sem, s, mdl););
+          recordNondet (nondet, BB, sem, &s, mdl);
+          cex.push_back (&BB);
+        }
+      }
+
+      // -- the last block is only executed if it does not return
+      const TerminatorInst *term = bb->getTerminator ();
+      if (k + 1 == ground.size () && term && isa<UnreachableInst> (term))
+      {
+        LOG ("cex", logValues (*bb, sem, s, mdl););
+        recordNondet (nondet, *bb, sem, &s, mdl);
+      }
+      
+      cex.push_back (bb);
+      prev = bb;
+      prevFact = fact;
+    }
+
+    return true;
+  }
+  
   void HornCex::getAnalysisUsage (AnalysisUsage &AU) const
   {
     AU.setPreservesAll ();
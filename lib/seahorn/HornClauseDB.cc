@@ -14,9 +14,27 @@ namespace seahorn
     m_vars.resize (std::distance (m_vars.begin (),
                                   std::unique (m_vars.begin (),
                                                m_vars.end ())));
+    m_uniqVars = m_vars.size ();
     return m_vars;
   }
 
+  const ExprVector &HornClauseDB::bvars (Expr reln) const
+  {
+    ExprVector &res = m_bvars [reln];
+    if (res.empty ())
+      for (unsigned i = 0, sz = bind::domainSz (reln); i < sz; ++i)
+        res.push_back (bind::bvar (i, bind::domainTy (reln, i)));
+    return res;
+  }
+  
+  void HornClauseDB::removeRelation (Expr fdecl)
+  {
+    m_rels.erase (std::remove (m_rels.begin (), m_rels.end (), fdecl), 
+                  m_rels.end ());
+    m_constraints.erase (fdecl);
+    m_bvars.erase (fdecl);
+  }
+
   void HornClauseDB::addConstraint (Expr pred, Expr lemma)
   {
     assert (bind::isFapp (pred));
@@ -26,12 +44,11 @@ namespace seahorn
     Expr reln = bind::fname (pred);
     assert (hasRelation (reln));
       
-    ExprMap sub;
-    unsigned idx = 0;
-    for (auto it = ++pred->args_begin (), end = pred->args_end (); it != end; ++it)
-      sub [*it] = bind::bvar (idx++, bind::typeOf (*it));
-      
-    m_constraints [reln].push_back (replace (lemma, sub));
+    Substitution sub (m_efac, 
+                      boost::make_iterator_range (++pred->args_begin (), 
+                                                  pred->args_end ()),
+                      bvars (reln));
+    m_constraints [reln].push_back (sub (lemma));
   }
 
   Expr HornClauseDB::getConstraints (Expr pred) const
@@ -46,15 +63,10 @@ namespace seahorn
     Expr lemma = mknary<AND> (mk<TRUE> (pred->efac ()),
                               m_constraints.at (reln).begin (), 
                               m_constraints.at (reln).end ());
-    ExprMap sub;
-    unsigned idx = 0;
-    for (auto it = ++pred->args_begin (), end = pred->args_end (); it != end; ++it)
-    {
-      Expr k = bind::bvar (idx++, bind::typeOf (*it));
-      sub [k] = pred->arg (idx);
-    }
-          
-    return replace (lemma, sub);
+    Substitution sub (m_efac, bvars (reln),
+                      boost::make_iterator_range (++pred->args_begin (), 
+                                                  pred->args_end ()));
+    return sub (lemma);
   }
   
   raw_ostream& HornClauseDB::write (raw_ostream& o) const
@@ -1,9 +1,12 @@
 #include "seahorn/HornClauseDBTransf.hh"
 #include "ufo/Expr.hpp"
+#include "ufo/ExprRewriter.hpp"
+#include "ufo/Stats.hh"
 
 namespace seahorn
 {
   using namespace expr;
+  using namespace ufo;
   using namespace std;
   
   // Return a new Horn rule whose head only has variables
@@ -68,4 +71,291 @@ namespace seahorn
       db.addRule (new_rule);
     }
   }
+
+  void simplifyHornClauseBodies (HornClauseDB &db)
+  {
+    // -- one rewriter for all rules so that the bodies share normal forms
+    op::Rewriter rw (db.getExprFactory ());
+
+    vector<HornRule> worklist;
+    boost::copy (db.getRules (), std::back_inserter(worklist));
+
+    for (auto rule: worklist)
+    {
+      Expr body = rw (rule.body ());
+      if (body == rule.body ()) continue;
+      db.removeRule (rule);
+      db.addRule (HornRule (rule.vars (), rule.head (), body));
+    }
+
+    Stats::uset ("HornRewriteCacheHits", rw.cache ().hits ());
+    Stats::uset ("HornRewriteCacheMisses", rw.cache ().misses ());
+    Stats::uset ("HornRewriteCacheEvictions", rw.cache ().evictions ());
+  }
+
+  namespace
+  {
+    /// How the rules use the arguments of one summary relation, and
+    /// how the relation is narrowed
+    struct SummaryUse
+    {
+      /// every head of the relation has a fresh variable at the position
+      std::vector<bool> freeInHead;
+      /// every use of the relation has a fresh variable at the position
+      std::vector<bool> unusedInBody;
+      /// the position appears in the constraints of the relation
+      std::vector<bool> constrained;
+      /// positions with the same value in every normal exit
+      std::vector<std::vector<bool> > same;
+      /// number of normal exits (enabled and no error)
+      unsigned exits;
+      /// the relation appears in a query
+      bool queried;
+      /// constraints of the relation over args
+      ExprVector args;
+      Expr lemma;
+
+      /// the narrowed relation. NULL if the relation is not changed
+      Expr newRel;
+      /// position in the old relation of every argument of newRel
+      std::vector<unsigned> keep;
+      /// (out, in) pairs: out is dropped and equal to in at every use
+      /// that exits normally
+      std::vector<std::pair<unsigned, unsigned> > merge;
+
+      SummaryUse () : exits (0), queried (false) {}
+    };
+
+    struct IsSummaryApp : public std::unary_function<Expr,bool>
+    {
+      const std::map<Expr,unsigned> &m_idx;
+      IsSummaryApp (const std::map<Expr,unsigned> &idx) : m_idx (idx) {}
+      bool operator() (Expr e) const
+      { return bind::isFapp (e) && m_idx.count (bind::fname (e)) > 0; }
+    };
+
+    void initUse (HornClauseDB &db, Expr rel, SummaryUse &u)
+    {
+      ExprFactory &efac = db.getExprFactory ();
+      unsigned sz = bind::domainSz (rel);
+      u.freeInHead.assign (sz, true);
+      u.unusedInBody.assign (sz, true);
+      u.constrained.assign (sz, false);
+      u.same.assign (sz, std::vector<bool> (sz, true));
+
+      for (unsigned i = 0; i < sz; ++i)
+      {
+        Expr argName = mkTerm<std::string> 
+          ("arg_" + boost::lexical_cast<std::string> (i), efac);
+        u.args.push_back (bind::mkConst (argName, bind::domainTy (rel, i)));
+      }
+      u.lemma = db.hasConstraints (rel) ? 
+        db.getConstraints (bind::fapp (rel, u.args)) : mk<TRUE> (efac);
+
+      ExprSet used;
+      filter (u.lemma, bind::IsConst (), std::inserter (used, used.begin ()));
+      for (unsigned i = 0; i < sz; ++i)
+        if (used.count (u.args [i]) > 0) u.constrained [i] = true;
+    }
+
+    void collectUses (const HornRule &r, const std::map<Expr,unsigned> &idx,
+                      std::vector<SummaryUse> &uses)
+    {
+      IsSummaryApp isSum (idx);
+      bind::IsConst isConst;
+
+      ExprVector apps;
+      filter (r.body (), isSum, std::back_inserter (apps));
+      Expr head = r.head ();
+      bool sumHead = isSum (head);
+      if (apps.empty () && !sumHead) return;
+
+      // -- number of summary arguments every variable appears in
+      std::map<Expr,unsigned> slots;
+      auto count = [&] (Expr app)
+      {
+        for (unsigned k = 1; k < app->arity (); ++k)
+          if (isConst (app->arg (k))) ++slots [app->arg (k)];
+      };
+      for (Expr app : apps) count (app);
+      if (sumHead) count (head);
+
+      // -- variables used outside of summary arguments
+      Substitution sub (head->efac ());
+      for (Expr app : apps) sub.add (app, mk<TRUE> (app->efac ()));
+      ExprSet rest;
+      filter (sub (r.body ()), isConst, std::inserter (rest, rest.begin ()));
+      if (!sumHead) filter (head, isConst, std::inserter (rest, rest.begin ()));
+
+      auto fresh = [&] (Expr v)
+      { return isConst (v) && slots [v] == 1 && rest.count (v) == 0; };
+
+      for (Expr app : apps)
+      {
+        SummaryUse &u = uses [idx.at (bind::fname (app))];
+        for (unsigned k = 1; k < app->arity (); ++k)
+          if (!fresh (app->arg (k))) u.unusedInBody [k - 1] = false;
+      }
+
+      if (!sumHead) return;
+      SummaryUse &u = uses [idx.at (bind::fname (head))];
+      unsigned sz = head->arity () - 1;
+      for (unsigned k = 0; k < sz; ++k)
+        if (!fresh (head->arg (k + 1))) u.freeInHead [k] = false;
+
+      // -- only normal exits tell what the callee changes. The values
+      // -- of a disabled or failed call are never observed
+      if (isOpX<FALSE> (head->arg (1)) || isOpX<TRUE> (head->arg (3))) return;
+      ++u.exits;
+      for (unsigned i = 0; i < sz; ++i)
+        for (unsigned j = 0; j < sz; ++j)
+          if (head->arg (i + 1) != head->arg (j + 1)) u.same [i][j] = false;
+    }
+
+    Expr narrowApp (Expr app, const SummaryUse &u)
+    {
+      ExprVector args;
+      for (unsigned k : u.keep) args.push_back (app->arg (k + 1));
+      return bind::fapp (u.newRel, args);
+    }
+
+    HornRule narrowRule (const HornRule &r, const std::map<Expr,unsigned> &idx,
+                         const std::vector<SummaryUse> &uses)
+    {
+      IsSummaryApp isSum (idx);
+
+      ExprVector apps;
+      filter (r.body (), isSum, std::back_inserter (apps));
+      Substitution sub (r.head ()->efac ());
+      for (Expr app : apps)
+      {
+        const SummaryUse &u = uses [idx.at (bind::fname (app))];
+        if (!u.newRel) continue;
+        Expr res = narrowApp (app, u);
+        // -- out == in is only known for normal exits, i.e., when the
+        // -- call is enabled and its outgoing error flag is false
+        Expr normal = boolop::land (app->arg (1), boolop::lneg (app->arg (3)));
+        for (auto &m : u.merge)
+          res = boolop::land (res, boolop::limp (normal,
+                                                 mk<EQ> (app->arg (m.first + 1),
+                                                         app->arg (m.second + 1))));
+        sub.add (app, res);
+      }
+
+      Expr head = r.head ();
+      if (isSum (head))
+      {
+        const SummaryUse &u = uses [idx.at (bind::fname (head))];
+        if (u.newRel) head = narrowApp (head, u);
+      }
+
+      if (sub.empty () && head == r.head ()) return r;
+      return HornRule (r.vars (), head, sub.empty () ? r.body () : sub (r.body ()));
+    }
+  }
+
+  void minimizeSummaries (HornClauseDB &db, std::vector<SummarySignature> &sums)
+  {
+    for (SummarySignature &sig : sums)
+      if (sig.kept.empty ())
+        for (unsigned i = 0, sz = bind::domainSz (sig.rel); i < sz; ++i)
+          sig.kept.push_back (i);
+
+    unsigned dropped = 0;
+    unsigned merged = 0;
+    while (true)
+    {
+      std::map<Expr,unsigned> idx;
+      for (unsigned i = 0; i < sums.size (); ++i) idx [sums [i].rel] = i;
+
+      std::vector<SummaryUse> uses (sums.size ());
+      for (unsigned i = 0; i < sums.size (); ++i) initUse (db, sums [i].rel, uses [i]);
+      for (Expr q : db.getQueries ())
+      {
+        ExprVector apps;
+        filter (q, IsSummaryApp (idx), std::back_inserter (apps));
+        for (Expr app : apps) uses [idx [bind::fname (app)]].queried = true;
+      }
+      for (const HornRule &r : db.getRules ()) collectUses (r, idx, uses);
+
+      // -- first, drop arguments nobody looks at
+      bool changed = false;
+      for (unsigned i = 0; i < sums.size (); ++i)
+      {
+        SummaryUse &u = uses [i];
+        unsigned sz = bind::domainSz (sums [i].rel);
+        for (unsigned k = 0; k < sz; ++k)
+          if (k < 3 || u.queried || u.constrained [k] ||
+              !(u.freeInHead [k] || u.unusedInBody [k]))
+            u.keep.push_back (k);
+        changed = changed || u.keep.size () < sz;
+      }
+
+      // -- then, merge outputs the callee never changes into the inputs
+      if (!changed)
+        for (unsigned i = 0; i < sums.size (); ++i)
+        {
+          SummarySignature &sig = sums [i];
+          SummaryUse &u = uses [i];
+          unsigned sz = bind::domainSz (sig.rel);
+          auto isOutput = [&] (unsigned k)
+          { return sig.kept [k] < sig.output.size () && sig.output [sig.kept [k]]; };
+
+          u.keep.clear ();
+          for (unsigned k = 0; k < sz; ++k)
+          {
+            unsigned in = 3;
+            if (k >= 3 && !u.queried && u.exits > 0 && 
+                !u.constrained [k] && isOutput (k))
+              for (; in < sz; ++in)
+                if (!isOutput (in) && u.same [in][k]) break;
+            if (k >= 3 && in < sz) u.merge.push_back (std::make_pair (k, in));
+            else u.keep.push_back (k);
+          }
+          changed = changed || !u.merge.empty ();
+        }
+
+      if (!changed) break;
+
+      for (unsigned i = 0; i < sums.size (); ++i)
+      {
+        Expr rel = sums [i].rel;
+        SummaryUse &u = uses [i];
+        if (u.keep.size () == bind::domainSz (rel)) continue;
+        ExprVector sorts;
+        for (unsigned k : u.keep) sorts.push_back (bind::domainTy (rel, k));
+        sorts.push_back (bind::rangeTy (rel));
+        u.newRel = bind::fdecl (bind::fname (rel), sorts);
+      }
+
+      for (HornRule &r : db.getRules ()) r = narrowRule (r, idx, uses);
+
+      for (unsigned i = 0; i < sums.size (); ++i)
+      {
+        SummarySignature &sig = sums [i];
+        SummaryUse &u = uses [i];
+        if (!u.newRel) continue;
+
+        db.removeRelation (sig.rel);
+        db.registerRelation (u.newRel);
+        if (!isOpX<TRUE> (u.lemma))
+        {
+          ExprVector args;
+          for (unsigned k : u.keep) args.push_back (u.args [k]);
+          db.addConstraint (bind::fapp (u.newRel, args), u.lemma);
+        }
+
+        dropped += bind::domainSz (sig.rel) - u.keep.size () - u.merge.size ();
+        merged += u.merge.size ();
+
+        std::vector<unsigned> kept;
+        for (unsigned k : u.keep) kept.push_back (sig.kept [k]);
+        sig.kept.swap (kept);
+        sig.rel = u.newRel;
+      }
+    }
+
+    Stats::uset ("HornSummaryArgsDropped", dropped);
+    Stats::uset ("HornSummaryArgsMerged", merged);
+  }
 }
@@ -35,6 +35,11 @@ FlexTrace ("horn-flex-trace", cl::Hidden, cl::init (false));
 static llvm::cl::opt<bool>
 HornChildren ("horn-child-order", cl::Hidden, cl::init(true));
 
+static llvm::cl::opt<bool>
+Rewrite ("horn-rewrite",
+         cl::desc ("Simplify the body of every rule before solving"),
+         cl::init (false));
+
 static llvm::cl::opt<unsigned>
 PdrContexts ("horn-pdr-contexts", cl::Hidden, cl::init (500));
 
@@ -72,6 +77,13 @@ namespace seahorn
     params.set (":pdr.max_num_contexts", PdrContexts);
     fp.set (params);
     
+    if (Rewrite)
+    {
+      Stats::resume ("Horn rewrite");
+      simplifyHornClauseBodies (db);
+      Stats::stop ("Horn rewrite");
+    }
+    
     db.loadZFixedPoint (fp, SkipConstraints);
     
     Stats::resume ("Horn");
@@ -6,6 +6,8 @@
 
 #include "seahorn/config.h"
 
+#include "ufo/Stats.hh"
+
 #include "llvm/Support/CommandLine.h"
 
 static llvm::cl::opt<bool>
@@ -59,10 +61,16 @@ namespace seahorn
     }
     else if (HornClauseFormat == MCMT)
     {
-      // -- normalize db
-      // -- create writer
-      McMtWriter<llvm::raw_fd_ostream> writer (db, hm.getZContext ());
+      // -- any linear encoding is flattened into a single
+      // -- transition system by the writer
+      McMtWriter<llvm::raw_ostream> writer (db, hm.getZContext ());
       writer.write (m_out);
+
+      // -- the writer simplifies every transition
+      auto &sc = hm.getZContext ().getSimplifyCache ();
+      Stats::uset ("Z3SimplifyCacheHits", sc.hits ());
+      Stats::uset ("Z3SimplifyCacheMisses", sc.misses ());
+      Stats::uset ("Z3SimplifyCacheEvictions", sc.evictions ());
     }
     else 
     {
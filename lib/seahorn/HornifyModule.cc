@@ -13,6 +13,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/DenseSet.h"
 #include "seahorn/Support/BoostLlvmGraphTraits.hh"
 
 #include "boost/range.hpp"
@@ -25,11 +26,13 @@
 
 #include "seahorn/Analysis/CutPointGraph.hh"
 #include "seahorn/Analysis/CanFail.hh"
+#include "seahorn/Analysis/ModuleSummary.hh"
 #include "ufo/Smt/EZ3.hh"
 #include "ufo/Stats.hh"
 
 #include "seahorn/HornifyFunction.hh"
 #include "seahorn/FlatHornifyFunction.hh"
+#include "seahorn/HornClauseDBTransf.hh"
 
 #ifdef HAVE_CRAB_LLVM
 #include "crab_llvm/CrabLlvm.hh"
@@ -75,6 +78,18 @@ AbortOnRecursion("horn-abort-on-recursion",
                  llvm::cl::desc ("Abort if program has a recursive call"),
                  cl::init (false));
 
+static llvm::cl::opt<bool>
+DemandDriven("horn-demand-driven",
+             llvm::cl::desc ("Only encode main and the functions it calls that may fail. "
+                             "Other calls havoc the memory regions they modify"),
+             cl::init (false));
+
+static llvm::cl::opt<bool>
+MinSummaries("horn-min-summaries",
+             llvm::cl::desc ("Drop summary arguments that are unconstrained or unused "
+                             "and merge regions that a function only reads"),
+             cl::init (false));
+
 static llvm::cl::opt<bool>
 NoVerification("horn-no-verif",
           llvm::cl::desc ("Generate only SMT2 encoding (i.e. even if there are no assertions)"),
@@ -86,9 +101,60 @@ namespace seahorn
 {
   char HornifyModule::ID = 0;
 
+  /// Marks the summary arguments that F writes: outgoing memory
+  /// regions and the return value. Follows the layout of the
+  /// summary built by HornifyFunction::extractFunctionInfo
+  static void summaryOutputs (SmallStepSymExec &sem, const Function &F,
+                              const FunctionInfo &fi, std::vector<bool> &out)
+  {
+    out.assign (3, false);
+    for (const BasicBlock &bb : F)
+    {
+      if (!isa<ReturnInst> (bb.getTerminator ())) continue;
+      for (const Instruction &inst : bb)
+      {
+        const CallInst *ci = dyn_cast<const CallInst> (&inst);
+        const Function *cf = ci ? ci->getCalledFunction () : NULL;
+        if (!cf) continue;
+        bool isOut = cf->getName ().equals ("shadow.mem.out");
+        if ((isOut || cf->getName ().equals ("shadow.mem.in")) &&
+            sem.symb (*ci->getArgOperand (1)))
+          out.push_back (isOut);
+      }
+      break;
+    }
+    // -- do not guess if the exit block does not match the summary
+    if (out.size () != 3 + fi.regions.size ())
+      out.assign (3 + fi.regions.size (), false);
+    
+    out.resize (out.size () + fi.args.size () + fi.globals.size (), false);
+    if (fi.ret) out.push_back (true);
+  }
+
+  /// Keeps in fi only the arguments of the narrowed summary
+  static void narrowFunctionInfo (FunctionInfo &fi, const SummarySignature &sig)
+  {
+    unsigned nRegions = fi.regions.size ();
+    unsigned nArgs = fi.args.size ();
+    unsigned nGlobals = fi.globals.size ();
+
+    FunctionInfo res;
+    res.sumPred = sig.rel;
+    for (unsigned k : sig.kept)
+    {
+      if (k < 3) continue;
+      k -= 3;
+      if (k < nRegions) res.regions.push_back (fi.regions [k]);
+      else if ((k -= nRegions) < nArgs) res.args.push_back (fi.args [k]);
+      else if ((k -= nArgs) < nGlobals) res.globals.push_back (fi.globals [k]);
+      else res.ret = fi.ret;
+    }
+    fi = res;
+  }
+
   HornifyModule::HornifyModule () :
     ModulePass (ID), m_zctx (m_efac),  m_db (m_efac),
-    m_td(0), m_canFail(0)
+    m_td(0), m_canFail(0), m_cpg(0)
   {
   }
 
@@ -114,37 +180,14 @@ namespace seahorn
       return Changed;
     }
 
-    bool canFail = false; 
+    ModuleSummary &summary = getAnalysis<ModuleSummary> ();
+    summary.refresh (M);
 
     // --- optimizer or ms can detect an error and make main
     //     unreachable. In that case, it will insert a call to
-    //     seahorn.fail.
-    Function* failureFn = M.getFunction ("seahorn.fail");
-    if (!canFail)
-    {
-      for (auto &I : boost::make_iterator_range (inst_begin(*main), 
-                                                 inst_end (*main)))
-      {
-        if (!isa<CallInst> (&I)) continue;
-        // -- look through pointer casts
-        Value *v = I.stripPointerCasts ();
-        CallSite CS (const_cast<Value*> (v));
-        const Function *fn = CS.getCalledFunction ();
-        canFail |= (fn == failureFn);
-      }
-    }
-    
-    // --- we ask the can-fail analysis if no function can fail.
-    if (!canFail)
-    {      
-      Function* errorFn = M.getFunction ("verifier.error");      
-      for (auto &f : M)
-      { 
-        if ((&f == errorFn) || (&f == failureFn)) 
-          continue; 
-        canFail |= (m_canFail->canFail (&f)); 
-      }
-    }
+    //     seahorn.fail. Otherwise, some function other than the
+    //     error functions must be able to fail.
+    bool canFail = summary.callsSeahornFail (main) || summary.anyMayFail (M);
 
     // --- no function can fail so the program is trivially safe.
     if (!canFail && !NoVerification)
@@ -197,11 +240,47 @@ namespace seahorn
 
 
     CallGraph &CG = getAnalysis<CallGraphWrapperPass> ().getCallGraph ();
+
+    unsigned numBlocks = 0;
+    for (const Function &f : M) numBlocks += f.size ();
+    m_blocks.reserve (numBlocks);
+
+    // -- functions whose encoding is required: main and the may-fail
+    // -- functions it calls. Only the inter-procedural encoding
+    // -- connects callees to main
+    DenseSet<const Function*> required;
+    if (DemandDriven)
+    {
+      required.insert (main);
+      SmallVector<const Function*, 16> wl;
+      if (InterProc) wl.push_back (main);
+      while (!wl.empty ())
+      {
+        const Function *f = wl.pop_back_val ();
+        for (auto &call : *CG [f])
+        {
+          const Function *callee = call.second->getFunction ();
+          if (!callee || callee->isDeclaration ()) continue;
+          if (!summary.mayFail (callee) || required.count (callee)) continue;
+          required.insert (callee);
+          wl.push_back (callee);
+        }
+      }
+
+      for (const Function &f : M)
+        if (!f.isDeclaration () && !required.count (&f))
+          m_sem->abstractFunction (f);
+      LOG ("horn-demand", errs () << "Encoding " << required.size ()
+           << " functions on demand\n";);
+    }
+
     for (auto it = scc_begin (&CG); !it.isAtEnd (); ++it)
     {
       const std::vector<CallGraphNode*> &scc = *it;
       CallGraphNode *cgn = scc.front ();
       Function *f = cgn->getFunction ();
+      // -- calls to functions that are not required are abstracted
+      if (DemandDriven && f && !required.count (f)) continue;
       if (it.hasLoop () || scc.size () > 1)
       {
         errs () << "WARNING RECURSION at " << (f ? f->getName () : "nil") << "\n";
@@ -232,6 +311,31 @@ namespace seahorn
       m_db.addQuery (mk<TRUE> (m_efac));
     }
 
+    // -- narrow the summaries once all rules are known. Calls are not
+    // -- encoded after this point, so FunctionInfo only describes the
+    // -- narrowed summary predicates
+    if (InterProc && MinSummaries)
+    {
+      ScopedStats _mst ("HornifyModule.minSummaries");
+      std::vector<const Function*> fns;
+      std::vector<SummarySignature> sums;
+      for (const Function &F : M)
+      {
+        if (F.isDeclaration () || !m_sem->hasFunctionInfo (F)) continue;
+        const FunctionInfo &fi = m_sem->getFunctionInfo (F);
+        if (!fi.sumPred) continue;
+        SummarySignature sig;
+        sig.rel = fi.sumPred;
+        summaryOutputs (*m_sem, F, fi, sig.output);
+        fns.push_back (&F);
+        sums.push_back (sig);
+      }
+
+      minimizeSummaries (m_db, sums);
+      for (unsigned i = 0; i < fns.size (); ++i)
+        narrowFunctionInfo (m_sem->getFunctionInfo (*fns [i]), sums [i]);
+    }
+
     /**
        TODO:
          - name basic blocks so that there are no name clashes between functions (DONE)
@@ -303,15 +407,28 @@ namespace seahorn
       hf.reset (new FlatLargeHornifyFunction (*this, InterProc));
 
 
-    /// -- allocate LiveSymbols
-    auto r = m_ls.insert (std::make_pair (&F, LiveSymbols (F, m_efac, *m_sem)));
-    assert (r.second);
     /// -- run LiveSymbols
-    r.first->second.run ();
+    m_ls.reset (new LiveSymbols (F, m_efac, *m_sem));
+    m_ls->run ();
+
+    /// -- keep only the live symbols of every block
+    unsigned base = m_blocks.size ();
+    m_blocks.resize (base + F.size ());
+    for (const BasicBlock &bb : F)
+    {
+      m_blocks [base].live = m_ls->live (&bb);
+      m_bbIdx [&bb] = base++;
+    }
 
     /// -- hornify function
     hf->runOnFunction (F);
 
+    /// -- only the rules and FunctionInfo of F are needed from now
+    /// -- on. Release the per-function analyses before the next one
+    m_ls.reset ();
+    if (m_cpg) m_cpg->releaseMemory ();
+    m_cpg = NULL;
+
     return false;
   }
 
@@ -321,6 +438,7 @@ namespace seahorn
     AU.addRequired<llvm::DataLayoutPass>();
 
     AU.addRequired<seahorn::CanFail> ();
+    AU.addRequired<seahorn::ModuleSummary> ();
     AU.addRequired<ufo::NameValues>();
 
     AU.addRequired<llvm::CallGraphWrapperPass> ();
@@ -336,19 +454,19 @@ namespace seahorn
 
   const LiveSymbols& HornifyModule::getLiveSybols (const Function &F) const
   {
-    auto it = m_ls.find (&F);
-    assert (it != m_ls.end ());
-    return it->second;
+    // -- only available while F is hornified
+    assert (m_ls);
+    return *m_ls;
   }
 
   const Expr HornifyModule::bbPredicate (const BasicBlock &BB)
   {
-    const BasicBlock *bb = &BB;
-    Expr res = m_bbPreds [bb];
-    if (res) return res;
-
+    auto it = m_bbIdx.find (&BB);
+    assert (it != m_bbIdx.end ());
+    BlockInfo &bi = m_blocks [it->second];
+    if (bi.pred) return bi.pred;
 
-    const ExprVector &lv = live (bb);
+    const ExprVector &lv = bi.live;
     ExprVector sorts;
     sorts.reserve (lv.size () + 1);
 
@@ -360,10 +478,9 @@ namespace seahorn
     }
     sorts.push_back (mk<BOOL_TY> (m_efac));
 
-    Expr name = mkTerm (bb, m_efac);
-    res = bind::fdecl (name, sorts);
-    m_bbPreds [bb] = res;
-    return res;
+    Expr name = mkTerm (&BB, m_efac);
+    bi.pred = bind::fdecl (name, sorts);
+    return bi.pred;
   }
 
   bool HornifyModule::isBbPredicate (Expr pred) const
@@ -5,7 +5,7 @@
 #include "avy/AvyDebug.h"
 
 #include "llvm/Analysis/CFG.h"
-#include "seahorn/Support/SortTopo.hh"
+#include "seahorn/Support/BitSet.hh"
 
 
 namespace seahorn
@@ -103,7 +103,8 @@ namespace seahorn
     }
     
     // find block with return and make extras live there
-    for (const BasicBlock *bb : m_rtopo)
+    for (const BasicBlock *bb : boost::make_iterator_range (m_cfg.blocks ().rbegin (),
+                                                            m_cfg.blocks ().rend ()))
       if (isa<ReturnInst> (bb->getTerminator ()))
       {
         m_liveInfo [bb].addLive (extras);
@@ -114,9 +115,11 @@ namespace seahorn
   
   void LiveSymbols::localPass ()
   {
-    RevTopoSort (m_f, m_rtopo);
+    m_cfg.build (m_f);
       
-    for (const BasicBlock *bb : m_rtopo)
+    // -- in reverse topological order
+    for (const BasicBlock *bb : boost::make_iterator_range (m_cfg.blocks ().rbegin (),
+                                                            m_cfg.blocks ().rend ()))
     {
       LiveInfo &li = m_liveInfo [bb];
       
@@ -172,46 +175,64 @@ namespace seahorn
   
   void LiveSymbols::globalPass ()
   {
+    // -- number the symbols that are live somewhere in sorted order,
+    // -- so that the bits of a set enumerate its symbols sorted
+    ExprVector syms;
+    for (auto &kv : m_liveInfo) boost::copy (kv.second.live (), std::back_inserter (syms));
+    boost::sort (syms);
+    syms.erase (std::unique (syms.begin (), syms.end ()), syms.end ());
+    
+    auto toBits = [&syms] (const ExprVector &v, BitSet &bits)
+    {
+      for (Expr e : v)
+      {
+        auto it = std::lower_bound (syms.begin (), syms.end (), e);
+        if (it != syms.end () && *it == e) bits.set (it - syms.begin ());
+      }
+    };
+    
+    // -- live set of every block, and symbols killed on every CFG
+    // -- edge. Blocks are visited in reverse topological order
+    unsigned n = m_cfg.size ();
+    std::vector<BitSet> live (n, BitSet (syms.size ()));
+    std::vector<BitSet> kill;
+    for (unsigned i = n; i-- > 0; )
+    {
+      LiveInfo &srcLi = m_liveInfo [m_cfg.block (i)];
+      toBits (srcLi.live (), live [i]);
+      
+      BitSet defs (syms.size ());
+      toBits (srcLi.defs (), defs);
+      for (unsigned idx = 0, sz = m_cfg.succs (i).size (); idx < sz; ++idx)
+      {
+        kill.push_back (defs);
+        toBits (srcLi.edge_defs (idx), kill.back ());
+      }
+    }
+    
     // -- propagate live symbol information until nothing can be propagated
     // -- based on local live symbol information computed by initialize()
     bool dirty;
     do
     {
       dirty = false;
-      for (const BasicBlock *src : m_rtopo)
-      {
-        unsigned idx = 0;
-        LiveInfo &srcLi = m_liveInfo[src];
-          
-        for (const BasicBlock *dst : 
-               boost::make_iterator_range (succ_begin (src), succ_end (src)))
-        {
-          LiveInfo &dstLi = m_liveInfo[dst];
-            
-          ExprVector live;
-          live.reserve (dstLi.live ().size ());
-            
-          ExprVector live2;
-          live2.reserve (live.size ());
-            
-          boost::set_difference (dstLi.live (), 
-                                 srcLi.edge_defs (idx++), 
-                                 std::back_inserter (live));
-          boost::set_difference (live, srcLi.defs (), 
-                                 std::back_inserter (live2));
-            
-          live.clear ();
-          boost::set_difference (live2, srcLi.live (), 
-                                 std::back_inserter (live));
-            
-          if (!live.empty ())
-          {
-            dirty = true;
-            srcLi.addLive (live);
-          }
-        }
-      }
+      unsigned edg = 0;
+      for (unsigned i = n; i-- > 0; )
+        for (unsigned dst : m_cfg.succs (i))
+          // -- live(src) |= live(dst) minus edge defs and defs of src
+          if (live [i].unionWithout (live [dst], kill [edg++])) dirty = true;
     } while (dirty);
+    
+    for (unsigned i = 0; i < n; ++i)
+    {
+      LiveInfo &li = m_liveInfo [m_cfg.block (i)];
+      if (live [i].count () == li.live ().size ()) continue;
+      
+      ExprVector v;
+      for (int j = live [i].find_first (); j >= 0; j = live [i].find_next (j))
+        v.push_back (syms [j]);
+      li.setLive (v);
+    }
   }  
   
   void LiveSymbols::symExec (SymStore &s, const BasicBlock &bb) 
@@ -6,6 +6,8 @@
 #include "seahorn/Transforms/Instrumentation/ShadowMemDsa.hh"
 
 #include "ufo/ufo_iterators.hpp"
+#include "ufo/ExprAig.hpp"
+#include "ufo/ExprLinear.hpp"
 #include "llvm/Support/CommandLine.h"
 
 //#include <queue>
@@ -26,11 +28,42 @@ ArrayGlobalConstraints("horn-array-global-constraints",
                        ("Extend global constraints to arrays"),
                        cl::init (false));
 
+static llvm::cl::opt<bool>
+AutoGlobalConstraints ("horn-auto-global-constraints",
+                       llvm::cl::desc
+                       ("Emit definitions that are safe to hoist as global "
+                        "(i.e., unguarded) constraints"),
+                       cl::init (false));
+
+static llvm::cl::opt<bool>
+ArrayChains ("horn-array-chains",
+             llvm::cl::desc ("Keep stores of a basic block as a single store "
+                             "chain and resolve loads against it"),
+             cl::init (false));
+
 static llvm::cl::opt<bool>
 StrictlyLinear ("horn-strictly-la",
                 llvm::cl::desc ("Generate strictly Linear Arithmetic constraints"),
                 cl::init (true));
 
+static llvm::cl::opt<bool>
+AigEdges ("horn-aig",
+          llvm::cl::desc ("Simplify the Boolean structure of large-step "
+                          "edges with an And-Inverter Graph"),
+          cl::init (false));
+
+static llvm::cl::opt<bool>
+MergeJoins ("horn-merge-joins",
+            llvm::cl::desc ("Merge values at joins inside a large-step edge "
+                            "with if-then-else instead of fresh variables"),
+            cl::init (false));
+
+static llvm::cl::opt<unsigned>
+MergeMaxSize ("horn-merge-max-size",
+              llvm::cl::desc ("Merged values larger than this (DAG size) "
+                              "get a fresh variable"),
+              cl::init (64));
+
 static llvm::cl::opt<bool>
 EnableDiv ("horn-enable-div",
                 llvm::cl::desc ("Enable division constraints."),
@@ -97,6 +130,10 @@ namespace
     Expr m_inMem;
     /// -- current write memory
     Expr m_outMem;
+    /// -- instruction that defines the current write memory
+    const Instruction *m_outMemDef;
+    /// -- memory defined as a store chain instead of a variable
+    SmallVector<const Instruction*, 8> m_chains;
     /// --- true if the current read/write is to unique memory location
     bool m_uniq;
     
@@ -113,6 +150,7 @@ namespace
       zeroE = mkTerm<mpz_class> (0, m_efac);
       oneE = mkTerm<mpz_class> (1, m_efac);
       m_uniq = false;
+      m_outMemDef = nullptr;
       resetActiveLit ();
       // -- first two arguments are reserved for error flag
       m_fparams.push_back (falseE);
@@ -136,6 +174,11 @@ namespace
     // -- add conditional side condition
     void addCondSide (Expr c) {m_side.push_back (boolop::limp (m_activeLit, c));}
     
+    /// -- activation literal of the definition of I. Definitions that
+    /// -- are safe to emit globally are not guarded
+    Expr defAct (const Instruction &I)
+    { return GlobalConstraints || m_sem.isGlobalDef (I) ? trueE : m_activeLit; }
+    
   };
   
   struct SymExecVisitor : public InstVisitor<SymExecVisitor>, 
@@ -151,27 +194,8 @@ namespace
     void visitPHINode (PHINode &I) { /* do nothing */ }
     
      
-    Expr geq (Expr op0, Expr op1)
-    {
-      if (op0 == op1) return trueE;
-      if (isOpX<MPZ> (op0) && isOpX<MPZ> (op1))
-        return
-          getTerm<mpz_class> (op0) >=
-          getTerm<mpz_class> (op1) ? trueE : falseE;
-      
-      return mk<GEQ> (op0, op1);
-    }
-
-    Expr lt (Expr op0, Expr op1)
-    {
-      if (op0 == op1) return falseE;
-      if (isOpX<MPZ> (op0) && isOpX<MPZ> (op1))
-        return
-          getTerm<mpz_class> (op0) <
-          getTerm<mpz_class> (op1) ? trueE : falseE;
-      
-      return mk<LT> (op0, op1);
-    }
+    Expr geq (Expr op0, Expr op1) { return linear::mkGeq (op0, op1); }
+    Expr lt (Expr op0, Expr op1) { return linear::mkLt (op0, op1); }
     
     Expr mkUnsignedLT (Expr op0, Expr op1)
     {
@@ -203,10 +227,10 @@ namespace
       switch (I.getPredicate ())
       {
       case CmpInst::ICMP_EQ:
-        res = mk<IFF>(lhs, mk<EQ>(op0,op1));
+        res = mk<IFF>(lhs, linear::mkEq (op0,op1));
         break;
       case CmpInst::ICMP_NE:
-        res = mk<IFF>(lhs, mk<NEQ>(op0,op1));
+        res = mk<IFF>(lhs, linear::mkNeq (op0,op1));
         break;
       case CmpInst::ICMP_UGT:
         res = mk<IFF> (lhs, mkUnsignedLT (op1, op0));
@@ -219,34 +243,34 @@ namespace
             res = mk<IFF> (lhs, boolop::lneg (op0));
         }
         else
-          res = mk<IFF>(lhs,mk<GT>(op0,op1));
+          res = mk<IFF>(lhs,linear::mkGt (op0,op1));
         break;
       case CmpInst::ICMP_UGE:
         res = mk<OR> (mk<IFF> (lhs, mk<EQ> (op0, op1)),
                       mk<IFF> (lhs, mkUnsignedLT (op1, op0)));
         break;
       case CmpInst::ICMP_SGE:
-        res = mk<IFF>(lhs,mk<GEQ>(op0,op1));
+        res = mk<IFF>(lhs,linear::mkGeq (op0,op1));
         break;
       case CmpInst::ICMP_ULT:
         res = mk<IFF> (lhs, mkUnsignedLT (op0, op1));
         break;
       case CmpInst::ICMP_SLT:
-        res = mk<IFF>(lhs,mk<LT>(op0,op1));
+        res = mk<IFF>(lhs,linear::mkLt (op0,op1));
         break; 
       case CmpInst::ICMP_ULE:
         res = mk<OR> (mk<IFF> (lhs, mk<EQ> (op0, op1)),
                       mk<IFF> (lhs, mkUnsignedLT (op0, op1)));
         break;
       case CmpInst::ICMP_SLE:
-        res = mk<IFF>(lhs,mk<LEQ>(op0,op1));
+        res = mk<IFF>(lhs,linear::mkLeq (op0,op1));
         break;
       default:
         break;
       }       
 
       // -- optionally guard branch conditions by activation literals
-      Expr act = GlobalConstraints ? trueE : m_activeLit;
+      Expr act = defAct (I);
       if (res)
         m_side.push_back (boolop::limp (act, res));
     }
@@ -262,7 +286,7 @@ namespace
       Expr op1 = lookup (*I.getFalseValue ());
       
       
-      Expr act = GlobalConstraints ? trueE : m_activeLit;
+      Expr act = defAct (I);
       if (cond && op0 && op1)
         m_side.push_back (boolop::limp (act, mk<EQ> (lhs, mk<ITE> (cond, op0, op1))));
     }
@@ -374,7 +398,7 @@ namespace
           break;
 	}
 
-      Expr act = GlobalConstraints ? trueE : m_activeLit;
+      Expr act = defAct (i);
       if (res) m_side.push_back (boolop::limp (act, res));
     }
 
@@ -386,7 +410,7 @@ namespace
       {
           factor = factor * 2;
       }
-      Expr res = mk<EQ>(lhs ,mk<MULT>(op1, mkTerm<mpz_class> (factor, m_efac)));        
+      Expr res = mk<EQ>(lhs ,linear::mkMult (op1, mkTerm<mpz_class> (factor, m_efac)));
       return res;
     }
     Expr doAShr (Expr lhs, Expr op1, const ConstantInt *op2)
@@ -416,10 +440,10 @@ namespace
       switch(i.getOpcode())
       {
       case BinaryOperator::Add:
-        res = mk<EQ>(lhs ,mk<PLUS>(op1, op2));
+        res = mk<EQ>(lhs ,linear::mkPlus (op1, op2));
         break;
       case BinaryOperator::Sub:
-        res = mk<EQ>(lhs ,mk<MINUS>(op1, op2));
+        res = mk<EQ>(lhs ,linear::mkMinus (op1, op2));
         break;
       case BinaryOperator::Mul:
         // if StrictlyLinear, then require that at least one
@@ -427,7 +451,7 @@ namespace
         if (!StrictlyLinear || 
             isOpX<MPZ> (op1) || isOpX<MPZ> (op2) || 
             isOpX<MPQ> (op1) || isOpX<MPQ> (op2))
-          res = mk<EQ>(lhs ,mk<MULT>(op1, op2));
+          res = mk<EQ>(lhs ,linear::mkMult (op1, op2));
         break;
       case BinaryOperator::SDiv:
       case BinaryOperator::UDiv:
@@ -456,7 +480,7 @@ namespace
         break;
       }
 
-      Expr act = GlobalConstraints ? trueE : m_activeLit;
+      Expr act = defAct (i);
       
       // -- always guard division
       if (EnableDiv &&
@@ -473,7 +497,8 @@ namespace
     void visitReturnInst (ReturnInst &I)
     {
       // -- skip return argument of main
-      if (I.getParent ()->getParent ()->getName ().equals ("main")) return;
+      if (m_sem.intrinsicKind (*I.getParent ()->getParent ()) == intrinsic::MAIN)
+        return;
       
       if (I.getNumOperands () > 0)
         lookup (*I.getOperand (0));
@@ -492,7 +517,7 @@ namespace
       
       if (!op0) return;
 
-      Expr act = GlobalConstraints ? trueE : m_activeLit;
+      Expr act = defAct (I);
       if (I.getType ()->isIntegerTy (1))
       {
         // truncation to 1 bit amounts to 'is_even' predicate.
@@ -524,7 +549,7 @@ namespace
       }
       
       Expr op = m_sem.ptrArith (m_s, *gep.getPointerOperand (), ps, ts);
-      Expr act = GlobalConstraints ? trueE : m_activeLit;
+      Expr act = defAct (gep);
       if (op)
       {
         m_side.push_back (boolop::limp (act, mk<EQ> (lhs, op)));
@@ -561,47 +586,21 @@ namespace
           op0 = mk<ITE> (op0, one, zeroE);
       }
       
-      Expr act = GlobalConstraints ? trueE : m_activeLit;
+      Expr act = defAct (I);
       m_side.push_back (boolop::limp (act, mk<EQ> (lhs, op0)));
     }
     
-    void visitCallSite (CallSite CS)
+    void visitCallSite (CallSite CS) { m_sem.execCallSite (*this, CS); }
+    
+    /// -- hooks of SmallSymExecCore::execCallSite
+    Expr activeLit () { return m_activeLit; }
+    
+    bool execIntrinsic (CallSite CS, intrinsic::Kind kind)
     {
-      assert (CS.isCall ());
-      const Function *f = CS.getCalledFunction ();
-      
       Instruction &I = *CS.getInstruction ();
-      BasicBlock &BB = *I.getParent ();
-      
-      // -- unknown/indirect function call
-      if (!f)
-      { 
-        // XXX Use DSA and/or Devirt to handle better
-        assert (m_fparams.size () == 3);
-        visitInstruction (I);
-        return;
-      }
-      
-      const Function &F = *f;
-      const Function &PF = *I.getParent ()->getParent ();
-      
-      // skip intrinsic functions
-      if (F.isIntrinsic ()) { assert (m_fparams.size () == 3); return;}
-    
-      
-      if (F.getName ().startswith ("verifier.assume"))
-      {
-        Expr c = lookup (*CS.getArgument (0));
-        if (F.getName ().equals ("verifier.assume.not")) c = boolop::lneg (c);
-        
-        assert (m_fparams.size () == 3);
-        // -- assumption is only active when error flag is false
-        addCondSide (boolop::lor (m_s.read (m_sem.errorFlag (BB)), c));
-      }
-      else if (F.getName ().equals ("calloc") && m_inMem && m_outMem && m_sem.isTracked (I))
+      if (kind == intrinsic::CALLOC && m_inMem && m_outMem && m_sem.isTracked (I))
       {
         havoc (I);
-        assert (m_fparams.size () == 3);
         assert (!m_uniq);
         if (IgnoreCalloc)
           m_side.push_back (mk<EQ> (m_outMem, m_inMem));
@@ -614,125 +613,97 @@ namespace
                                     op::array::constArray
                                     (sort::intTy (m_efac), zeroE)));
         }
+        return true;
       }
       
-      // else if (F.getName ().equals ("verifier.assert"))
-      // {
-      //   Expr ein = m_s.read (m_sem.errorFlag ());
-      //   Expr eout = m_s.havoc (m_sem.errorFlag ());
-      //   Expr cond = lookup (*CS.getArgument (0));
-      //   m_side.push_back (boolop::limp (cond,
-      //                                   mk<EQ> (ein, eout)));
-      //   m_side.push_back (boolop::limp (boolop::lneg (cond), eout));
-      // }
-      // else if (F.getName ().equals ("verifier.error"))
-      //   m_side.push_back (m_s.havoc (m_sem.errorFlag ()));
-      else if (m_sem.hasFunctionInfo (F))
+      if (kind == intrinsic::GV_INIT && m_inMem && m_outMem)
       {
-        const FunctionInfo &fi = m_sem.getFunctionInfo (F);
-        
-        // enabled
-        m_fparams [0] = m_activeLit; // activation literal
-        // error flag in
-        m_fparams [1] = (m_s.read (m_sem.errorFlag (BB)));
-        // error flag out
-        m_fparams [2] = (m_s.havoc (m_sem.errorFlag (BB)));
-        for (const Argument *arg : fi.args)
-          m_fparams.push_back (m_s.read (symb (*CS.getArgument (arg->getArgNo ()))));
-        for (const GlobalVariable *gv : fi.globals)
-          m_fparams.push_back (m_s.read (symb (*gv)));
-        
-        if (fi.ret) m_fparams.push_back (m_s.havoc (symb (I)));
-        
-        LOG ("arg_error", 
-             if (m_fparams.size () != bind::domainSz (fi.sumPred))
-             {
-               errs () << "Call instruction: " << I << "\n";
-               errs () << "Caller: " << PF << "\n";
-               errs () << "Callee: " << F << "\n";
-               // errs () << "Sum predicate: " << *fi.sumPred << "\n";
-               errs () << "m_fparams.size: " << m_fparams.size () << "\n";
-               errs () << "Domain size: " << bind::domainSz (fi.sumPred) << "\n";
-               errs () << "m_fparams\n";
-               for (auto r : m_fparams) errs () << *r << "\n";
-               errs () << "regions: " << fi.regions.size () 
-                       << " args: " << fi.args.size () 
-                       << " globals: " << fi.globals.size () 
-                       << " ret: " << fi.ret << "\n";
-               errs () << "regions\n";
-               for (auto r : fi.regions) errs () << *r << "\n";
-               errs () << "args\n";
-               for (auto r : fi.args) errs () << *r << "\n";
-               errs () << "globals\n";
-               for (auto r : fi.globals) errs () << *r << "\n";
-               if (fi.ret) errs () << "ret: " << *fi.ret << "\n";
-             }
-             );
-        
-        assert (m_fparams.size () == bind::domainSz (fi.sumPred));
-        m_side.push_back (bind::fapp (fi.sumPred, m_fparams));
-        
-        m_fparams.clear ();
-        m_fparams.push_back (falseE);
-        m_fparams.push_back (falseE);
-        m_fparams.push_back (falseE);
-      }
-      else if (F.getName ().startswith ("shadow.mem") && 
-               m_sem.isTracked (I))
-      {
-        if (F.getName ().equals ("shadow.mem.init"))
-          m_s.havoc (symb(I));
-        else if (F.getName ().equals ("shadow.mem.load"))
-        {
-          const Value &v = *CS.getArgument (1);
-          m_inMem = m_s.read (symb (v));
-          m_uniq = extractUniqueScalar (CS) != nullptr;
-        }
-        else if (F.getName ().equals ("shadow.mem.store"))
-        {
-          m_inMem = m_s.read (symb (*CS.getArgument (1)));
-          m_outMem = m_s.havoc (symb (I));
-          m_uniq = extractUniqueScalar (CS) != nullptr;
-        }
-        else if (F.getName ().equals ("shadow.mem.arg.ref"))
-          m_fparams.push_back (m_s.read (symb (*CS.getArgument (1))));
-        else if (F.getName ().equals ("shadow.mem.arg.mod"))
-        {
-          m_fparams.push_back (m_s.read (symb (*CS.getArgument (1))));
-          m_fparams.push_back (m_s.havoc (symb (I)));
-        }
-        else if (F.getName ().equals ("shadow.mem.arg.new"))
-          m_fparams.push_back (m_s.havoc (symb (I)));
-        else if (!PF.getName ().equals ("main") && 
-                 F.getName ().equals ("shadow.mem.in"))
+        // -- ShadowMemDsa leaves one call per region, with every
+        // -- global of the region as an argument
+        Expr init;
+        if (m_uniq)
         {
-          m_s.read (symb (*CS.getArgument (1)));
+          const GlobalVariable *gv =
+            dyn_cast<GlobalVariable> (CS.getArgument (0)->stripPointerCasts ());
+          if (gv) init = initLeaf (*gv->getInitializer ());
         }
-        else if (!PF.getName ().equals ("main") &&
-                 F.getName ().equals ("shadow.mem.out"))
+        else
         {
-          m_s.read (symb (*CS.getArgument (1)));
+          init = op::array::constArray (sort::intTy (m_efac), zeroE);
+          for (unsigned i = 0; init && i < CS.arg_size (); ++i)
+          {
+            const GlobalVariable *gv =
+              dyn_cast<GlobalVariable> (CS.getArgument (i)->stripPointerCasts ());
+            Expr base = gv ? lookup (*gv) : Expr ();
+            if (!base || !initRegion (init, base, *gv->getInitializer ()))
+              init.reset ();
+          }
         }
-        else if (!PF.getName ().equals ("main") && 
-                 F.getName ().equals ("shadow.mem.arg.init"))
+        // -- otherwise the region is left unconstrained
+        if (init)
+          m_side.push_back (boolop::limp (m_activeLit, mk<EQ> (m_outMem, init)));
+        m_inMem.reset ();
+        m_outMem.reset ();
+        return true;
+      }
+      
+      return false;
+    }
+
+    /// -- value of a leaf of a global initializer, as kept in memory
+    Expr initLeaf (const Constant &c)
+    {
+      if (const ConstantInt *ci = dyn_cast<ConstantInt> (&c))
+      {
+        if (ci->getType ()->isIntegerTy (1)) return ci->isOne () ? oneE : zeroE;
+        return mkTerm<mpz_class> (expr::toMpz (ci->getValue ()), m_efac);
+      }
+      if (c.isNullValue ()) return zeroE;
+      if (c.getType ()->isPointerTy ()) return lookup (c);
+      return Expr ();
+    }
+
+    /// -- stores the non-zero leaves of the initializer c of the
+    /// -- object at addr into mem. False if a leaf cannot be expressed
+    bool initRegion (Expr &mem, Expr addr, const Constant &c)
+    {
+      if (c.isNullValue ()) return true;
+
+      Type *ty = c.getType ();
+      if (StructType *st = dyn_cast<StructType> (ty))
+      {
+        for (unsigned i = 0, e = st->getNumElements (); i < e; ++i)
         {
-          // regions initialized in main are global. We want them to
-          // flow to the arguments
-          /* do nothing */
+          Expr off = mkTerm<mpz_class> (m_sem.fieldOff (st, i), m_efac);
+          if (!initRegion (mem, linear::mkPlus (addr, off),
+                           *c.getAggregateElement (i)))
+            return false;
         }
+        return true;
       }
-      else
+      if (ArrayType *at = dyn_cast<ArrayType> (ty))
       {
-        if (m_fparams.size () > 3)
+        unsigned sz = m_sem.storageSize (at->getElementType ());
+        for (unsigned i = 0, e = at->getNumElements (); i < e; ++i)
         {
-          m_fparams.resize (3);
-          errs () << "WARNING: skipping a call to " << F.getName () 
-                  << " (recursive call?)\n";
+          Expr off = mkTerm<mpz_class> (mpz_class (mpz_class (i) * sz), m_efac);
+          if (!initRegion (mem, linear::mkPlus (addr, off),
+                           *c.getAggregateElement (i)))
+            return false;
         }
-        
-        visitInstruction (*CS.getInstruction ());
+        return true;
       }
-          
+
+      Expr v = initLeaf (c);
+      if (!v) return false;
+      mem = op::array::store (mem, addr, v);
+      return true;
+    }
+    
+    void shadowMemAccess (CallSite CS, intrinsic::Kind kind)
+    {
+      if (kind == intrinsic::SHADOW_MEM_STORE) m_outMemDef = CS.getInstruction ();
+      m_uniq = extractUniqueScalar (CS) != nullptr;
     }
     
     void visitAllocaInst (AllocaInst &I)
@@ -740,7 +711,7 @@ namespace
       if (!m_sem.isTracked (I)) return;
       
       Expr lhs = havoc(I);
-      Expr act = GlobalConstraints ? trueE : m_activeLit;
+      Expr act = defAct (I);
 
       // -- alloca always returns a non-zero address
       m_side.push_back (boolop::limp (act, mk<GT> (lhs, zeroE)));
@@ -763,7 +734,7 @@ namespace
       
       if (!m_sem.isTracked (I)) return;
       
-      Expr act = GlobalConstraints ? trueE : m_activeLit;
+      Expr act = defAct (I);
       // -- define (i.e., use) the value of the instruction
       Expr lhs = havoc (I);
       if (!m_inMem) return;
@@ -780,7 +751,8 @@ namespace
       }
       else if (Expr op0 = lookup (*I.getPointerOperand ()))
       {
-        Expr rhs = op::array::select (m_inMem, op0);
+        Expr rhs = ArrayChains ? linear::mkSelect (m_inMem, op0) :
+          op::array::select (m_inMem, op0);
         if (I.getType ()->isIntegerTy (1))
           // -- convert to Boolean
           rhs = mk<NEQ> (rhs, mkTerm (mpz_class(0), m_efac));
@@ -827,7 +799,14 @@ namespace
         Expr idx = lookup (*I.getPointerOperand ());
       
         if (!ArrayGlobalConstraints) act = m_activeLit;
-        if (idx && v)
+        if (idx && v && ArrayChains && m_outMemDef)
+        {
+          // -- the new memory is the store itself. It is named by
+          // -- nameChains() if it is used outside of the chain
+          m_s.write (symb (*m_outMemDef), linear::mkStore (m_inMem, idx, v));
+          m_chains.push_back (m_outMemDef);
+        }
+        else if (idx && v)
           m_side.push_back (boolop::limp (act,
                                           mk<EQ> (m_outMem, 
                                                   op::array::store (m_inMem, idx, v))));
@@ -835,6 +814,7 @@ namespace
       
       m_inMem.reset ();
       m_outMem.reset ();
+      m_outMemDef = nullptr;
     }
     
     
@@ -845,16 +825,46 @@ namespace
       Expr lhs = havoc (I);
       const Value &v0 = *I.getOperand (0);
       
-      Expr act = GlobalConstraints ? trueE : m_activeLit;
+      Expr act = defAct (I);
       Expr u = lookup (v0);
       if (u) m_side.push_back (boolop::limp (act, mk<EQ> (lhs, u)));
     }
     
+    /// true if the memory defined by I is only read by loads and
+    /// stores of its own basic block
+    bool isChainLocal (const Instruction &I)
+    {
+      for (const User *u : I.users ())
+      {
+        const CallInst *ci = dyn_cast<CallInst> (u);
+        if (!ci || ci->getParent () != I.getParent ()) return false;
+        const Function *fn = ci->getCalledFunction ();
+        if (!fn) return false;
+        intrinsic::Kind kind = m_sem.intrinsicKind (*fn);
+        if (kind != intrinsic::SHADOW_MEM_LOAD &&
+            kind != intrinsic::SHADOW_MEM_STORE) return false;
+      }
+      return true;
+    }
+    
+    /// gives a variable to every store chain that leaves the block
+    void nameChains ()
+    {
+      Expr act = ArrayGlobalConstraints ? trueE : m_activeLit;
+      for (const Instruction *I : m_chains)
+      {
+        if (isChainLocal (*I)) continue;
+        Expr chain = read (*I);
+        m_side.push_back (boolop::limp (act, mk<EQ> (havoc (*I), chain)));
+      }
+      m_chains.clear ();
+    }
+    
     void initGlobals (const BasicBlock &BB)
     {
       const Function &F = *BB.getParent ();
       if (&F.getEntryBlock () != &BB) return;
-      if (!F.getName ().equals ("main")) return;
+      if (m_sem.intrinsicKind (F) != intrinsic::MAIN) return;
       
       const Module &M = *F.getParent ();
       for (const GlobalVariable &g : boost::make_iterator_range (M.global_begin (),
@@ -882,44 +892,68 @@ namespace
                        ExprVector &side, const BasicBlock &dst) : 
       SymExecBase (s, sem, side), m_dst (dst) {}
 
-    void visitBasicBlock (BasicBlock &BB)
-    {
-      // -- evaluate all phi-nodes atomically. First read all incoming
-      // -- values, then update phi-nodes all together.
-      ExprVector ops;
-
-      auto curr = BB.begin ();
-      if (!isa<PHINode> (curr)) return;
-      
-      for (; PHINode *phi = dyn_cast<PHINode> (curr); ++curr)
-      {
-        // skip phi nodes that are not tracked
-        if (!m_sem.isTracked (*phi)) continue;
-        const Value &v = *phi->getIncomingValueForBlock (&m_dst);
-        ops.push_back (lookup (v));
-      }
-      
-      curr = BB.begin ();
-      for (unsigned i = 0; isa<PHINode> (curr); ++curr)
-      {
-        PHINode &phi = *cast<PHINode> (curr);
-        if (!m_sem.isTracked (phi)) continue;
-        Expr lhs = havoc (phi);
-        Expr act = GlobalConstraints ? trueE : m_activeLit;
-        Expr op0 = ops[i++];
-        if (op0) m_side.push_back (boolop::limp (act, mk<EQ> (lhs, op0)));
-      }
-    }
+    void visitBasicBlock (BasicBlock &BB) { m_sem.execPhis (*this, BB, m_dst); }
+    
+    /// -- hook of SmallSymExecCore::execPhis
+    void definePhi (PHINode &phi, Expr lhs, Expr val)
+    { if (val) m_side.push_back (boolop::limp (defAct (phi), mk<EQ> (lhs, val))); }
   };
 }
 
 namespace seahorn
 {
-  Expr UfoSmallSymExec::errorFlag (const BasicBlock &BB)
+  bool UfoSmallSymExec::shadowMem (const Value &v, const Value **scalar)
+  { return isShadowMem (v, scalar); }
+  
+  /// true if the constraint defining I is satisfiable for every value
+  /// of its operands, i.e., it never restricts anything but its own value
+  static bool isTotalDef (const Instruction &I)
   {
-    // -- if BB belongs to a function that cannot fail, errorFlag is always false
-    if (m_canFail && !m_canFail->canFail (BB.getParent ())) return falseE;
-    return this->SmallStepSymExec::errorFlag (BB);
+    if (const BinaryOperator *bo = dyn_cast<BinaryOperator> (&I))
+      // -- division is always guarded
+      switch (bo->getOpcode ())
+      {
+      case BinaryOperator::SDiv:
+      case BinaryOperator::UDiv:
+      case BinaryOperator::SRem:
+      case BinaryOperator::URem:
+      case BinaryOperator::AShr:
+        return false;
+      default:
+        return true;
+      }
+    
+    return isa<CmpInst> (I) || isa<SelectInst> (I) ||
+      isa<CastInst> (I) || isa<GetElementPtrInst> (I) ||
+      isa<LoadInst> (I) || isa<AllocaInst> (I);
+  }
+  
+  bool UfoSmallSymExec::isGlobalDef (const Instruction &I)
+  {
+    if (!AutoGlobalConstraints) return false;
+    
+    auto it = m_globalDefs.find (&I);
+    if (it != m_globalDefs.end ()) return it->second;
+    
+    // -- phi-nodes are defined once per incoming edge, each time in a
+    // -- copy of the same store, so their variable is not fresh
+    bool res = !isa<PHINode> (I) && isTotalDef (I);
+    
+    // -- every user is a non-phi instruction of the same block. Then
+    // -- the value is not live at any block boundary, so it is never
+    // -- in the store before the block executes and is never read by
+    // -- a head or by another block. Its variable is fresh and only
+    // -- constrained by the definition and by constraints of the same
+    // -- block, which share the activation literal.
+    for (const Use &u : I.uses ())
+    {
+      if (!res) break;
+      const Instruction *user = dyn_cast<Instruction> (u.getUser ());
+      res = user && !isa<PHINode> (user) && user->getParent () == I.getParent ();
+    }
+    
+    m_globalDefs [&I] = res;
+    return res;
   }
   
   void UfoSmallSymExec::exec (SymStore &s, const BasicBlock &bb, ExprVector &side,
@@ -928,6 +962,7 @@ namespace seahorn
     SymExecVisitor v(s, *this, side);
     v.setActiveLit (act);
     v.visit (const_cast<BasicBlock&>(bb));
+    v.nameChains ();
     v.resetActiveLit ();
   }
     
@@ -935,6 +970,7 @@ namespace seahorn
   {
     SymExecVisitor v (s, *this, side);
     v.visit (const_cast<Instruction&>(inst));
+    v.nameChains ();
   }
     
   
@@ -948,211 +984,12 @@ namespace seahorn
     v.resetActiveLit ();
   }
 
-  Expr UfoSmallSymExec::ptrArith (SymStore &s, 
-                                  const Value &base,
-                                  SmallVectorImpl<const Value*> &ps,
-                                  SmallVectorImpl<const Type*> &ts)
-  {
-    Expr res = lookup (s, base);
-    if (!res) return res;
-    
-    for (unsigned i = 0; i < ps.size (); ++i)
-    {
-      if (const StructType *st = dyn_cast<const StructType> (ts [i]))
-      {
-        if (const ConstantInt *ci = dyn_cast<const ConstantInt> (ps [i]))
-        {
-          Expr off = mkTerm<mpz_class> (fieldOff (st, ci->getZExtValue ()), m_efac);
-          res = mk<PLUS> (res, off);
-        }
-        else assert (0);
-      }
-      else if (const SequentialType *seqt = dyn_cast<const SequentialType> (ts [i]))
-      {
-        Expr sz = mkTerm<mpz_class> (storageSize (seqt->getElementType ()), m_efac);
-        res = mk<PLUS> (res, mk<MULT> (lookup (s, *ps[i]), sz));
-      }
-    }
-    return res;
-  }
-  
-  unsigned UfoSmallSymExec::storageSize (const llvm::Type *t) 
-  {return m_td->getTypeStoreSize (const_cast<Type*> (t));}
-  
-  unsigned UfoSmallSymExec::fieldOff (const StructType *t, unsigned field)
-  {
-    return m_td->getStructLayout (const_cast<StructType*>(t))->getElementOffset (field);
-  }
-    
-  Expr UfoSmallSymExec::symb (const Value &I)
-  {
-    assert (!isa<UndefValue>(&I));
-
-    // -- basic blocks are mapped to Bool constants
-    if (const BasicBlock *bb = dyn_cast<const BasicBlock> (&I))
-      return bind::boolConst 
-        (mkTerm<const BasicBlock*> (bb, m_efac));
-    
-    // -- constants are mapped to values
-    if (const Constant *cv = dyn_cast<const Constant> (&I))
-    {
-      if (const ConstantInt *c = dyn_cast<const ConstantInt> (&I))
-      {
-        if (c->getType ()->isIntegerTy (1))
-          return c->isOne () ? mk<TRUE> (m_efac) : mk<FALSE> (m_efac);
-        mpz_class k = toMpz (c->getValue ());
-        return mkTerm<mpz_class> (k, m_efac);
-      }
-      else if (cv->isNullValue () || isa<ConstantPointerNull> (&I))
-        return mkTerm<mpz_class> (0, m_efac);
-      else if (const ConstantExpr *ce = dyn_cast<const ConstantExpr> (&I))
-      {
-        // -- if this is a cast, and not into a Boolean, strip it
-        // -- XXX handle Boolean casts if needed
-        if (ce->isCast () && 
-            (ce->getType ()->isIntegerTy () || ce->getType ()->isPointerTy ()) && 
-            ! ce->getType ()->isIntegerTy (1))
-   
-        {
-          if (const ConstantInt* val = dyn_cast<const ConstantInt>(ce->getOperand (0)))
-          {
-            mpz_class k = toMpz (val->getValue ());
-            return mkTerm<mpz_class> (k, m_efac);
-          }
-          // -- strip cast
-          else return symb (*ce->getOperand (0));
-        }
-      }
-    }   
-     
-    // -- everything else is mapped to a constant
-    Expr v = mkTerm<const Value*> (&I, m_efac);
-    
-    const Value *scalar = nullptr;
-    if (isShadowMem (I, &scalar))
-    {
-      if (scalar)
-        // -- create a constant with the name v[scalar]
-        return bind::intConst
-          (op::array::select (v, mkTerm<const Value*> (scalar, m_efac)));
-    
-      if (m_trackLvl >= MEM)
-      {
-        Expr intTy = sort::intTy (m_efac);
-        Expr ty = sort::arrayTy (intTy, intTy);
-        return bind::mkConst (v, ty);
-      }
-    }
-    
-      
-    if (isTracked (I))
-      return I.getType ()->isIntegerTy (1) ? 
-        bind::boolConst (v) : bind::intConst (v);
-    
-    return Expr(0);
-  }
-  
-  const Value &UfoSmallSymExec::conc (Expr v)
-  {
-    assert (isOpX<FAPP> (v));
-    // name of the app
-    Expr u = bind::fname (v);
-    // name of the fdecl
-    u = bind::fname (u);
-    assert (isOpX<VALUE> (v));
-    return *getTerm<const Value*> (v);
-  }
-  
-  
-  bool UfoSmallSymExec::isTracked (const Value &v) 
-  {
-    const Value* scalar;
-    
-    // -- shadow values represent memory regions
-    // -- only track them when memory is tracked
-    if (isShadowMem (v, &scalar))
-      return scalar != nullptr || m_trackLvl >= MEM;
-    
-    
-    // -- a pointer
-    if (v.getType ()->isPointerTy ())
-    {
-      // -- XXX A hack because shadow.mem generates not well formed
-      // -- bitcode that contains future references. A register that
-      // -- is defined later is used to name a shadow region in the
-      // -- beginning of the function. Perhaps there is a better
-      // -- solution. For now, we just do not track anything that came
-      // -- that way.
-      if (v.hasOneUse ())
-        if (const CallInst *ci = dyn_cast<const CallInst> (*v.user_begin ()))
-          if (const Function *fn = ci->getCalledFunction ())
-            if (fn->getName ().startswith ("shadow.mem")) return false;
-      
-      return m_trackLvl >= PTR;
-    }
-    
-    
-    // -- always track integer registers
-    return v.getType ()->isIntegerTy ();
-  }
-  
-  Expr UfoSmallSymExec::lookup (SymStore &s, const Value &v)
-  {
-    Expr u = symb (v);
-    // if u is defined it is either an fapp or a constant
-    if (u) return bind::isFapp (u) ? s.read (u) : u;
-    return Expr (0);
-  }
-
-  void UfoSmallSymExec::execEdg (SymStore &s, const BasicBlock &src,
-                                 const BasicBlock &dst, ExprVector &side)
-  {
-    exec (s, src, side, trueE);
-    execBr (s, src, dst, side, trueE);
-    execPhi (s, dst, src, side, trueE);
-    
-    // an edge into a basic block that does not return includes the block itself
-    const TerminatorInst *term = dst.getTerminator ();
-    if (term && isa<const UnreachableInst> (term)) exec (s, dst, side, trueE);
-  }
-  
-  void UfoSmallSymExec::execBr (SymStore &s, const BasicBlock &src, const BasicBlock &dst, 
-                                ExprVector &side, Expr act)
-  {
-    // the branch condition
-    if (const BranchInst *br = dyn_cast<const BranchInst> (src.getTerminator ()))
-    {
-      if (br->isConditional ())
-      {
-        const Value &c = *br->getCondition ();
-        if (const ConstantInt *ci = dyn_cast<const ConstantInt> (&c))
-        {
-          if ((ci->isOne () && br->getSuccessor (0) != &dst) ||
-              (ci->isZero () && br->getSuccessor (1) != &dst))
-          {
-            side.clear ();
-            side.push_back (boolop::limp (act, s.read (errorFlag (src))));
-          }
-        }
-        else if (Expr target = lookup (s, c))
-        {
-          
-          Expr cond = br->getSuccessor (0) == &dst ? target : mk<NEG> (target);
-          cond = boolop::lor (s.read (errorFlag (src)), cond);
-          cond = boolop::limp (act, cond);
-          side.push_back (cond);
-        }
-        
-            
-      }
-    }   
-  }
-  
   void UfoLargeSymExec::execCpEdg (SymStore &s, const CpEdge &edge, 
                                    ExprVector &side)
   {
     const CutPoint &target = edge.target ();
     
+    ExprVector merged;
     bool first = true;
     for (const BasicBlock& bb : edge) 
     {
@@ -1161,11 +998,26 @@ namespace seahorn
         s.havoc (m_sem.symb (bb));
         m_sem.exec (s, bb, side, trueE);  
       }
-      else execEdgBb (s, edge, bb, side);
+      else execEdgBb (s, edge, bb, side, merged);
       first = false;
     }
     
-    execEdgBb (s, edge, target.bb (), side, true);
+    execEdgBb (s, edge, target.bb (), side, merged, true);
+    
+    // -- merged values are terms, not variables. Name them before
+    // -- they escape the edge, e.g., as arguments of the target
+    for (Expr k : merged)
+    {
+      Expr v = s.read (k);
+      side.push_back (mk<EQ> (s.havoc (k), v));
+    }
+  }
+  
+  Expr UfoLargeSymExec::conjoin (const ExprVector &side)
+  {
+    Expr tau = mknary<AND> (trueE, side);
+    if (AigEdges) tau = boolop::flat_aig (tau);
+    return tau;
   }
   
   namespace sem_detail
@@ -1187,7 +1039,8 @@ namespace seahorn
   
   void UfoLargeSymExec::execEdgBb (SymStore &s, const CpEdge &edge, 
                                    const BasicBlock &bb, 
-                                   ExprVector &side, bool last)
+                                   ExprVector &side, ExprVector &merged,
+                                   bool last)
   {
     ExprVector edges;
     
@@ -1221,6 +1074,13 @@ namespace seahorn
       
     // unique node with no successors is asserted to always be reachable
     if (last) side.push_back (bbV);
+    
+    if (MergeJoins && !last)
+    {
+      mergePhis (s, bb, preds, edges, side, merged);
+      m_sem.exec (s, bb, side, bbV);
+      return;
+    }
       
     /// -- generate constraints from the phi-nodes (keep them separate for now)
     std::vector<ExprVector> phiConstraints (preds.size ());
@@ -1275,6 +1135,77 @@ namespace seahorn
     
     
      
+  }
+    
+  void UfoLargeSymExec::mergePhis (SymStore &s, const BasicBlock &bb,
+                                   ArrayRef<const BasicBlock*> preds,
+                                   const ExprVector &edges, ExprVector &side,
+                                   ExprVector &merged)
+  {
+    // -- incoming values of the tracked phi-nodes, per edge. The
+    // -- store is in SSA form, so phi-nodes are the only keys that
+    // -- can differ between the predecessors
+    SmallVector<const PHINode*, 8> phis;
+    for (const Instruction &inst : bb)
+    {
+      const PHINode *phi = dyn_cast<PHINode> (&inst);
+      if (!phi) break;
+      if (m_sem.isTracked (*phi)) phis.push_back (phi);
+    }
+    
+    std::vector<ExprVector> vals (preds.size ());
+    for (unsigned j = 0; j < preds.size (); ++j)
+    {
+      SymStore es (s);
+      m_sem.execBr (es, *preds [j], bb, side, edges [j]);
+      for (const PHINode *phi : phis)
+        vals [j].push_back 
+          (m_sem.lookup (es, *phi->getIncomingValueForBlock (preds [j])));
+      s.uses (es.uses ());
+    }
+    
+    for (unsigned i = 0; i < phis.size (); ++i)
+    {
+      Expr key = m_sem.symb (*phis [i]);
+      
+      bool same = true, known = true;
+      for (unsigned j = 0; j < vals.size (); ++j)
+      {
+        if (!vals [j][i]) known = false;
+        else if (vals [j][i] != vals [0][i]) same = false;
+      }
+      
+      // -- the same value on every edge: no merge
+      if (known && same && !vals.empty ())
+      {
+        s.write (key, vals [0][i]);
+        if (!bind::isFapp (vals [0][i])) merged.push_back (key);
+        continue;
+      }
+      
+      Expr res;
+      if (known && !vals.empty ())
+      {
+        res = vals.back ()[i];
+        for (int j = vals.size () - 2; j >= 0; --j)
+          res = mk<ITE> (edges [j], vals [j][i], res);
+      }
+      
+      if (res && dagSize (res) <= MergeMaxSize)
+      {
+        s.write (key, res);
+        merged.push_back (key);
+        continue;
+      }
+      
+      // -- a fresh variable for large or partially unknown values
+      Expr v = s.havoc (key);
+      if (res) side.push_back (mk<EQ> (v, res));
+      else
+        for (unsigned j = 0; j < vals.size (); ++j)
+          if (vals [j][i]) 
+            side.push_back (boolop::limp (edges [j], mk<EQ> (v, vals [j][i])));
+    }
   }
     
     // 1. execute all basic blocks using small-step semantics in topological order
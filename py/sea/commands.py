@@ -635,12 +635,19 @@ class SeaTerm(sea.LimitedCmd):
         ap.add_argument ('--rank_func',
                          help='Choose Ranking Function Type',
                          choices=['max','lex','mul'], default='lex', dest='rank')
+        ap.add_argument ('--term-jobs', type=int, dest='term_jobs', metavar='N',
+                         help='Number of loops analyzed in parallel',
+                         default=1)
+        ap.add_argument ('--term-timeout', type=int, dest='term_timeout',
+                         metavar='SEC', help='Time limit per loop (0 = none)',
+                         default=0)
         return ap
 
     def run(self, args, extra):
         try:
             import term.termination as tt
-            tt.seaTerm(extra[len(extra)-1],args.rank)
+            tt.seaTerm(extra[len(extra)-1],args.rank,
+                       args.term_jobs,args.term_timeout)
         except Exception as e:
             raise IOError(str(e))
 
@@ -74,12 +74,73 @@ def ranking(store,var):
 
     return functions
 
-def piecewise(fp):
-    # program CFG
-    program = Program(fp)
+def _variables(program):
     parameters = program.parameters[1:]
-    variables = [z3.Var(i, sort) for (i,sort)
+    return [z3.Var(i, sort) for (i,sort)
         in zip(list(range(len(parameters))),parameters)]
+
+def _loop(program,node,paths):
+    """ returns the nodes, entry, loop and exit edges of the loop at node """
+    loop = set([n for path in paths for n in path])   # loop nodes
+    entry = set([(n,node)
+        for n in program.prev[node] - loop])  # entry edges
+    edges = set([n for path in paths
+        for n in zip(path[:-1],path[1:])])  # loop edges
+    # exit = set([(node,n)
+    #     for n in program.next[node] - loop])  # exit edges
+    exit = set([(i,n)
+        for i in loop for n in program.next[i] - loop])  # exit edges
+    return loop,entry,edges,exit
+
+def prove_loop(program,node,paths,kind,seeds=[]):
+    """ synthesizes a ranking function for the loop at node
+        seeds are candidate ranking functions (e.g., of an enclosing loop)
+        returns the candidate ranking functions and
+        a non-terminating execution (empty if the loop terminates)
+    """
+    variables = _variables(program)
+    arguments = program.arguments[1:]
+    loop,entry,edges,exit = _loop(program,node,paths)
+
+    bits = list()   # (potentially) terminating bits
+    pieces = [[z3.IntSort().cast(0)] + list(seeds)]  # candidate ranking functions
+    bit = program.get_bit(entry,node,kind,pieces,edges,exit)
+    while bit:
+        bit[node][0][-len(pieces)] -= bit[node][-1][-len(pieces)]
+        bits.append(bit[node][0][:len(bit[node][0])-len(pieces)+1])
+        rankings = ranking(bits,variables)
+        for i in range(len(bits)):
+            rankings = ranking(bits[:i+1],variables)
+        if kind == 'max':
+            if not rankings:
+                if debug: print
+                del bits[:-1]
+                rankings = ranking(bits,variables)
+            if debug: print 'bit:', zip(arguments + ['-'
+                for component in pieces],bits[-1])
+        else:
+            if not rankings:
+                if debug: print
+                if debug: print 'bit:', zip(arguments + ['-'
+                    for component in pieces],bits[-1])
+                bits = list()
+                rankings = [z3.IntSort().cast(0)]
+                pieces.insert(0,[])
+            else:
+                if debug: print 'bit:', zip(arguments + ['-'
+                    for component in pieces],bits[-1])
+            del pieces[0][1:]
+        pieces[0].extend(rankings)
+        if debug: print 'pieces:', [[z3.substitute_vars(x,*arguments)
+            for x in component] for component in pieces]
+        bit = program.get_bit(entry,node,kind,pieces,edges,exit)
+    # check candidate ranking functions
+    point = program.termination(entry,node,kind,pieces,edges,exit)
+    return pieces,point
+
+def prove(fp,kind):
+    # program CFG
+    program = Program(fp)
     arguments = program.arguments[1:]
 
     # loops identification
@@ -90,37 +151,7 @@ def piecewise(fp):
         # ...for all loops involving each node
         if loops[node]:
             if debug: print '\nloop:', loops[node], '\n'
-            loop = set([n for path in loops[node] for n in path])   # loop nodes
-            entry = set([(n,node)
-                for n in program.prev[node] - loop])  # entry edges
-            edges = set([n for path in loops[node]
-                for n in zip(path[:-1],path[1:])])  # loop edges
-            # exit = set([(node,n)
-            #     for n in program.next[node] - loop])  # exit edges
-            exit = set([(i,n)
-                for i in loop for n in program.next[i] - loop])  # exit edges
-
-            bits = list()   # (potentially) terminating bits
-            pieces = [[z3.IntSort().cast(0)]]    # candidate ranking functions
-            bit = program.get_bit(entry,node,'max',pieces,edges,exit)
-            while bit:
-                bit[node][0][-len(pieces)] -= bit[node][-1][-len(pieces)]
-                bits.append(bit[node][0][:len(bit[node][0])-len(pieces)+1])
-                rankings = ranking(bits,variables)
-                for i in range(len(bits)):
-                    rankings = ranking(bits[:i+1],variables)
-                if not rankings:
-                    if debug: print
-                    del bits[:-1]
-                    rankings = ranking(bits,variables)
-                if debug: print 'bit:', zip(arguments + ['-'
-                    for component in pieces],bits[-1])
-                pieces[0].extend(rankings)
-                if debug: print 'pieces:', [[z3.substitute_vars(x,*arguments)
-                    for x in component] for component in pieces]
-                bit = program.get_bit(entry,node,'max',pieces,edges,exit)
-            # check candidate ranking functions
-            point = program.termination(entry,node,'max',pieces,edges,exit)
+            pieces,point = prove_loop(program,node,loops[node],kind)
             pieces = [[z3.substitute_vars(x,*arguments)
                 for x in component] for component in pieces]
             if point:
@@ -136,109 +167,155 @@ def piecewise(fp):
     else:
         stat("Result", "FALSE")
 
-def lexicographic(fp):
-    # program CFG
-    program = Program(fp)
-    parameters = program.parameters[1:]
-    variables = [z3.Var(i, sort) for (i,sort)
-        in zip(list(range(len(parameters))),parameters)]
-    arguments = program.arguments[1:]
+def piecewise(fp): prove(fp,'max')
 
-    # loops identification
+def lexicographic(fp): prove(fp,'lex')
+
+
+def _coefficients(rank,v):
+    """ coefficients [m0, ..., mk, q] of a linear ranking function """
+    zero = [z3.IntVal(0) for i in range(v)]
+    q = z3.simplify(z3.substitute_vars(rank,*zero)).as_long()
+    m = list()
+    for i in range(v):
+        point = list(zero)
+        point[i] = z3.IntVal(1)
+        m.append(z3.simplify(z3.substitute_vars(rank,*point)).as_long() - q)
+    return m + [q]
+
+def _rank(coefficients,variables):
+    """ inverse of _coefficients """
+    rank = z3.IntSort().cast(coefficients[-1])
+    for (m,x) in zip(coefficients[:-1],variables):
+        if m != 0: rank += z3.IntSort().cast(m) * x
+    return rank
+
+def _worker(smt_file,kind,node,seeds,conn):
+    """ proves termination of the loop at node in a separate process
+        and sends the verdict, the ranking functions as strings and
+        the linear ranking functions as coefficients to conn
+    """
+    try:
+        program = Program(_parse(smt_file))
+        variables = _variables(program)
+        arguments = program.arguments[1:]
+        loops = program.loops_identification()
+        pieces,point = prove_loop(program,node,loops[node],kind,
+                                  [_rank(c,variables) for c in seeds])
+        shared = list()
+        for component in pieces:
+            for x in component:
+                try: shared.append(_coefficients(x,len(variables)))
+                except Exception: pass   # not linear, not shared
+        text = [[str(z3.substitute_vars(x,*arguments))
+            for x in component] for component in pieces]
+        conn.send((not point,text,[(str(a),v) for (a,v) in point],shared))
+    except Exception as e:
+        conn.send(None)
+    conn.close()
+
+def parallel(smt_file,kind,jobs,timeout):
+    """ proves termination of every loop in a separate process
+
+        up to jobs loops are analyzed concurrently, each for at most
+        timeout seconds (no limit if timeout is 0). A nested loop is
+        started once its innermost enclosing loop is done and gets
+        the ranking functions of the enclosing loop as candidates
+    """
+    import multiprocessing as mp
+
+    program = Program(_parse(smt_file))
     loops = program.loops_identification()
-    # proving termination...
-    rank = dict()
-    for node in loops:
-        # ...for all loops involving each node
-        if loops[node]:
-            if debug: print '\nloop:', loops[node]
-            loop = set([n for path in loops[node] for n in path])   # loop nodes
-            entry = set([(n,node)
-                for n in program.prev[node] - loop])  # entry edges
-            edges = set([n for path in loops[node]
-                for n in zip(path[:-1],path[1:])])  # loop edges
-            # exit = set([(node,n)
-            #     for n in program.next[node] - loop])  # exit edges
-            exit = set([(i,n)
-                for i in loop for n in program.next[i] - loop])  # exit edges
+    nodes = dict([(node,_loop(program,node,loops[node])[0])
+        for node in loops if loops[node]])
+    # innermost enclosing loop of every loop
+    parent = dict()
+    for node in nodes:
+        outer = [n for n in nodes if nodes[node] < nodes[n]]
+        parent[node] = min(outer,key=lambda n: len(nodes[n])) if outer else None
 
-            bits = list()   # (potentially) terminating bits
-            pieces = [[z3.IntSort().cast(0)]]    # candidate ranking functions
-            bit = program.get_bit(entry,node,'lex',pieces,edges,exit)
-            while bit:
-                bit[node][0][-len(pieces)] -= bit[node][-1][-len(pieces)]
-                bits.append(bit[node][0][:len(bit[node][0])-len(pieces)+1])
-                rankings = ranking(bits,variables)
-                for i in range(len(bits)):
-                    rankings = ranking(bits[:i+1],variables)
-                if not rankings:
-                    if debug: print
-                    if debug: print 'bit:', zip(arguments + ['-'
-                        for component in pieces],bits[-1])
-                    bits = list()
-                    rankings = [z3.IntSort().cast(0)]
-                    pieces.insert(0,[])
-                else:
-                    if debug: print 'bit:', zip(arguments + ['-'
-                        for component in pieces],bits[-1])
-                del pieces[0][1:]
-                pieces[0].extend(rankings)
-                if debug: print 'pieces:', [[z3.substitute_vars(x,*arguments)
-                        for x in component] for component in pieces]
-                bit = program.get_bit(entry,node,'lex',pieces,edges,exit)
-            # check candidate ranking functions
-            point = program.termination(entry,node,'lex',pieces,edges,exit)
-            pieces = [[z3.substitute_vars(x,*arguments)
-                for x in component] for component in pieces]
-            if point:
-                rank[node] = (False,point)
-                if debug: print 'non-terminating execution:', point
-                if debug: print '(partial) loop ranking functions:', pieces
+    seeds = dict([(node,[]) for node in nodes])
+    ready = [node for node in nodes if parent[node] is None]
+    waiting = set(nodes) - set(ready)
+    running = dict()
+    verdict = dict()
+    while ready or running:
+        while ready and len(running) < jobs:
+            node = ready.pop()
+            recv,send = mp.Pipe(False)
+            p = mp.Process(target=_worker,
+                           args=(smt_file,kind,node,seeds[node],send))
+            p.start()
+            running[node] = (p,recv,time.time())
+        time.sleep(0.05)
+        for node in running.keys():
+            p,recv,start = running[node]
+            elapsed = time.time() - start
+            res = None
+            if recv.poll():
+                res = recv.recv()
+                verdict[node] = 'UNKNOWN' if res is None else \
+                    ('TRUE' if res[0] else 'FALSE')
+            elif timeout > 0 and elapsed > timeout:
+                p.terminate()
+                verdict[node] = 'TIMEOUT'
+            elif p.is_alive():
+                continue
             else:
-                rank[node] = (True,pieces)
-                if debug: print 'loop ranking functions:', pieces
-    if debug: print '\nranking functions:', rank
-    if all([r[0] for r in rank.values()]):
+                verdict[node] = 'UNKNOWN'
+            p.join()
+            del running[node]
+
+            stat('Loop_%d' % node, verdict[node])
+            stat('Loop_%d_Time' % node, '%.2f' % elapsed)
+            if res is not None:
+                if debug: print '\nloop:', node, verdict[node], res[1], res[2]
+            # -- nested loops can start, seeded with our rankings
+            for n in list(waiting):
+                if parent[n] == node:
+                    waiting.remove(n)
+                    seeds[n] = seeds[node] + (res[3] if res else [])
+                    ready.append(n)
+
+    if all([v == 'TRUE' for v in verdict.values()]):
         stat("Result", "TRUE")
-    else:
+    elif any([v == 'FALSE' for v in verdict.values()]):
         stat("Result", "FALSE")
+    else:
+        stat("Result", "UNKNOWN")
 
 
 def stat (key, val): stats.put (key, val)
 
-def seaTerm(smt_file, rank_function):
+def _parse(smt_file):
+    fp = z3.Fixedpoint()
+    fp.set(engine='spacer')
+    fp.set('xform.inline_eager', False)
+    fp.set('xform.slice', False)
+    fp.set('xform.inline_linear', False)
+    fp.set('pdr.utvpi', False)
+    fp.set('xform.karr', True)
+    query = fp.parse_file(smt_file)
+    return fp
+
+def seaTerm(smt_file, rank_function, jobs=1, timeout=0):
     try:
         stat ('Result','UNKNOWN')
         stat ('Ranking_Function', rank_function)
-        fp = z3.Fixedpoint()
-        fp.set(engine='spacer')
-        fp.set('xform.inline_eager', False)
-        fp.set('xform.slice', False)
-        fp.set('xform.inline_linear', False)
-        fp.set('pdr.utvpi', False)
-        fp.set('xform.karr', True)
-        query = fp.parse_file(smt_file)
+        if rank_function not in ['max', 'lex']:
+            raise IOError('unknown ranking function template')
         with stats.timer('Termination'):
-            if rank_function == 'max':
-                piecewise(fp)
-            elif rank_function == 'lex':
-                lexicographic(fp)
+            if jobs > 1 or timeout > 0:
+                parallel(smt_file, rank_function, jobs, timeout)
             else:
-                raise IOError('unknown ranking function template')
+                prove(_parse(smt_file), rank_function)
     except Exception as e:
         raise IOError(str(e))
     finally:
         stats.brunch_print()
 
 def main(argv):
-    fp = z3.Fixedpoint()
-    fp.set(engine='spacer')
-    fp.set('xform.inline_eager', False)
-    fp.set('xform.slice', False)
-    fp.set('xform.inline_linear', False)
-    fp.set('pdr.utvpi', False)
-    fp.set('xform.karr', True)
-    query = fp.parse_file(argv[1])
+    fp = _parse(argv[1])
 
     # proving termination...
     if len(argv) < 3:
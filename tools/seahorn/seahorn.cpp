@@ -30,6 +30,7 @@
 #include "seahorn/Transforms/Scalar/LowerGvInitializers.hh"
 #include "seahorn/Transforms/Scalar/LowerCstExpr.hh"
 #include "seahorn/Transforms/Utils/RemoveUnreachableBlocksPass.hh"
+#include "seahorn/Support/GzStream.hh"
 
 #ifdef HAVE_CRAB_LLVM
 #include "crab_llvm/CrabLlvm.hh"
@@ -85,12 +86,14 @@ InputFilename(llvm::cl::Positional, llvm::cl::desc("<input LLVM bitcode file>"),
               llvm::cl::Required, llvm::cl::value_desc("filename"));
 
 static llvm::cl::opt<std::string>
-OutputFilename("o", llvm::cl::desc("Override output filename"),
+OutputFilename("o", llvm::cl::desc("Override output filename. "
+                                   "Compressed with gzip if it ends in .gz"),
                llvm::cl::init(""), llvm::cl::value_desc("filename"));
 
 
 static llvm::cl::opt<std::string>
-AsmOutputFilename("oll", llvm::cl::desc("Output analyzed bitcode"),
+AsmOutputFilename("oll", llvm::cl::desc("Output analyzed bitcode. "
+                                         "Compressed with gzip if it ends in .gz"),
                llvm::cl::init(""), llvm::cl::value_desc("filename"));
 
 static llvm::cl::opt<std::string>
@@ -147,6 +150,10 @@ int main(int argc, char **argv) {
   std::unique_ptr<llvm::Module> module;
   std::unique_ptr<llvm::tool_output_file> output;
   std::unique_ptr<llvm::tool_output_file> asmOutput;
+  // -- compressing filters on top of output and asmOutput. Declared
+  // -- after them so that they are finished before the files are closed
+  std::unique_ptr<llvm::raw_ostream> gzOutput;
+  std::unique_ptr<llvm::raw_ostream> gzAsmOutput;
   
 
   module = llvm::parseIRFile(InputFilename, err, context);
@@ -161,6 +168,8 @@ int main(int argc, char **argv) {
   if (!AsmOutputFilename.empty ())
     asmOutput = 
       llvm::make_unique<llvm::tool_output_file>(AsmOutputFilename.c_str(), error_code, 
+                                                seahorn::isGzFileName (AsmOutputFilename) ?
+                                                llvm::sys::fs::F_None :
                                                 llvm::sys::fs::F_Text);
   if (error_code) {
     if (llvm::errs().has_colors()) 
@@ -182,6 +191,11 @@ int main(int argc, char **argv) {
     if (llvm::errs().has_colors()) llvm::errs().resetColor();
     return 3;
   }
+
+  if (output && seahorn::isGzFileName (OutputFilename))
+    gzOutput.reset (new seahorn::raw_gz_ostream (output->os ()));
+  if (asmOutput && seahorn::isGzFileName (AsmOutputFilename))
+    gzAsmOutput.reset (new seahorn::raw_gz_ostream (asmOutput->os ()));
   
 
   ///////////////////////////////
@@ -261,15 +275,21 @@ int main(int argc, char **argv) {
       // -- XXX it is probably dangerous to strip shadows and solve at the same time
       pass_manager.add (seahorn::createStripShadowMemPass ());
     }
-    pass_manager.add (createPrintModulePass (asmOutput->os ()));
+    pass_manager.add (createPrintModulePass
+                      (gzAsmOutput ? *gzAsmOutput : asmOutput->os ()));
   }
   
-  if (!OutputFilename.empty ()) pass_manager.add (new seahorn::HornWrite (output->os ()));
+  if (!OutputFilename.empty ())
+    pass_manager.add (new seahorn::HornWrite
+                      (gzOutput ? *gzOutput : output->os ()));
   if (Crab) pass_manager.add (seahorn::createLoadCrabPass ()); 
   if (Solve) pass_manager.add (new seahorn::HornSolver ());
   if (Cex) pass_manager.add (new seahorn::HornCex ());
   pass_manager.run(*module.get());
   
+  // -- write the gzip trailers
+  gzOutput.reset ();
+  gzAsmOutput.reset ();
   if (!AsmOutputFilename.empty ()) asmOutput->keep ();
   if (!OutputFilename.empty ()) output->keep();
   if (PrintStats) ufo::Stats::PrintBrunch (llvm::outs ());
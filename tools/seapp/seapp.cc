@@ -21,6 +21,8 @@
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/MD5.h"
 
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Bitcode/ReaderWriter.h"
@@ -33,6 +35,7 @@
 #include "seahorn/Transforms/Scalar/PromoteVerifierCalls.hh"
 #include "seahorn/Transforms/Utils/RemoveUnreachableBlocksPass.hh"
 #include "seahorn/Transforms/Utils/DummyMainFunction.hh"
+#include "seahorn/Transforms/Utils/ParallelFunctionPasses.hh"
 #include "seahorn/Transforms/Scalar/LowerGvInitializers.hh"
 
 #include "seahorn/Analysis/CanAccessMemory.hh"
@@ -134,6 +137,80 @@ SROA_ScalarLoadThreshold ("sroa-scalar-load",
                           llvm::cl::desc ("Scalar load threshold for ScalarReplAggregates"),
                           llvm::cl::init (-1));
 
+static llvm::cl::opt<unsigned>
+Jobs ("jobs",
+      llvm::cl::desc ("Number of threads for function-level preprocessing"),
+      llvm::cl::init (1));
+
+static llvm::cl::opt<std::string>
+CacheDir ("cache-dir",
+          llvm::cl::desc ("Reuse preprocessed bitcode stored in the directory "
+                          "for the same input and options"),
+          llvm::cl::init (""), llvm::cl::value_desc ("dir"));
+
+static llvm::cl::opt<bool>
+PrintStats ("seapp-stats", llvm::cl::desc ("Print statistics"),
+            llvm::cl::init (false));
+
+/// the cache entry of this run: a hash of the input bitcode, the
+/// version and all options that can change the output
+static std::string getCacheFile (int argc, char **argv)
+{
+  auto input = llvm::MemoryBuffer::getFile (InputFilename);
+  if (!input) return "";
+
+  llvm::MD5 md5;
+  md5.update ((*input)->getBuffer ());
+  md5.update (llvm::StringRef (SEAHORN_VERSION_INFO));
+  for (int i = 1; i < argc; ++i)
+  {
+    llvm::StringRef arg (argv [i]);
+    if (arg == InputFilename) continue;
+
+    // -- options that do not change the output
+    llvm::StringRef name = arg.ltrim ('-');
+    if (name == "o" || name == "cache-dir" || name == "jobs") { ++i; continue; }
+    if (name.startswith ("o=") || name.startswith ("cache-dir=") ||
+        name.startswith ("jobs=") || name.startswith ("seapp-stats"))
+      continue;
+
+    md5.update (arg);
+    md5.update (llvm::StringRef ("", 1));
+  }
+
+  llvm::MD5::MD5Result res;
+  md5.final (res);
+  llvm::SmallString<32> key;
+  llvm::MD5::stringifyResult (res, key);
+  return CacheDir + "/" + key.str ().str () + (OutputAssembly ? ".ll" : ".bc");
+}
+
+/// copies the file in src to the output file
+static bool copyToOutput (const std::string &src, llvm::tool_output_file &out)
+{
+  auto buf = llvm::MemoryBuffer::getFile (src);
+  if (!buf) return false;
+  out.os () << (*buf)->getBuffer ();
+  return true;
+}
+
+/// stores the output file in the cache. Readers never see a partial
+/// entry: the entry is written to a temporary file and then renamed
+static void storeInCache (const std::string &entry)
+{
+  auto buf = llvm::MemoryBuffer::getFile (OutputFilename);
+  if (!buf) return;
+
+  int fd;
+  llvm::SmallString<128> tmp;
+  if (llvm::sys::fs::createUniqueFile (entry + ".%%%%%%", fd, tmp)) return;
+  {
+    llvm::raw_fd_ostream os (fd, true);
+    os << (*buf)->getBuffer ();
+  }
+  if (llvm::sys::fs::rename (tmp, entry)) llvm::sys::fs::remove (tmp);
+}
+
 // removes extension from filename if there is one
 std::string getFileName(const std::string &str) {
   std::string filename = str;
@@ -159,6 +236,29 @@ int main(int argc, char **argv) {
   std::unique_ptr<llvm::Module> module;
   std::unique_ptr<llvm::tool_output_file> output;
   
+  std::string cacheFile;
+  if (!CacheDir.empty () && !OutputFilename.empty ())
+  {
+    llvm::sys::fs::create_directories (CacheDir);
+    cacheFile = getCacheFile (argc, argv);
+  }
+
+  if (!cacheFile.empty () && llvm::sys::fs::exists (cacheFile))
+  {
+    output = llvm::make_unique<llvm::tool_output_file>
+      (OutputFilename.c_str(), error_code, llvm::sys::fs::F_None);
+    if (!error_code && copyToOutput (cacheFile, *output))
+    {
+      ufo::Stats::count ("seapp.cache.hit");
+      ufo::Stats::sset ("seapp.cache.entry", cacheFile);
+      output->keep ();
+      if (PrintStats) ufo::Stats::PrintBrunch (llvm::outs ());
+      return 0;
+    }
+    output.reset ();
+  }
+  if (!cacheFile.empty ()) ufo::Stats::count ("seapp.cache.miss");
+  
   module = llvm::parseIRFile(InputFilename, err, context);
   if (!module)
   {
@@ -186,6 +286,10 @@ int main(int argc, char **argv) {
   ///////////////////////////////
 
   llvm::PassManager pass_manager;
+  // -- module-level passes that must run before the function-level
+  // -- ones are split over threads
+  llvm::PassManager module_manager;
+  llvm::PassManager &early_manager = Jobs > 1 ? module_manager : pass_manager;
   llvm::PassRegistry &Registry = *llvm::PassRegistry::getPassRegistry();
   llvm::initializeAnalysis(Registry);
   
@@ -200,76 +304,90 @@ int main(int argc, char **argv) {
     dl = module->getDataLayout ();
   }
   if (dl) pass_manager.add (new llvm::DataLayoutPass ());
+  if (dl && Jobs > 1) module_manager.add (new llvm::DataLayoutPass ());
 
   // -- Create a main function if we do not have one.
-  pass_manager.add (new seahorn::DummyMainFunction ());
+  early_manager.add (new seahorn::DummyMainFunction ());
  
   // -- promote verifier specific functions to special names
-  pass_manager.add (new seahorn::PromoteVerifierCalls ());
+  early_manager.add (new seahorn::PromoteVerifierCalls ());
   
   // -- promote top-level mallocs to alloca
-  pass_manager.add (seahorn::createPromoteMallocPass ());
+  early_manager.add (seahorn::createPromoteMallocPass ());
 
   // -- turn loads from _Bool from truc to sgt
-  pass_manager.add (seahorn::createPromoteBoolLoadsPass ());
+  early_manager.add (seahorn::createPromoteBoolLoadsPass ());
 
   if (KillVaArg)
-    pass_manager.add (seahorn::createKillVarArgFnPass ());
+    early_manager.add (seahorn::createKillVarArgFnPass ());
   
   if (StripExtern)
-    pass_manager.add (seahorn::createStripUselessDeclarationsPass ());
+    early_manager.add (seahorn::createStripUselessDeclarationsPass ());
   
   // -- mark entry points of all functions
   if (!MixedSem && !CutLoops)
     // XXX should only be ran once. need better way to ensure that.
-    pass_manager.add (seahorn::createMarkFnEntryPass ());
+    early_manager.add (seahorn::createMarkFnEntryPass ());
   
   // turn all functions internal so that we can inline them if requested
-  pass_manager.add (llvm::createInternalizePass (llvm::ArrayRef<const char*>("main")));
+  early_manager.add (llvm::createInternalizePass (llvm::ArrayRef<const char*>("main")));
   
   // -- resolve indirect calls
   if (DevirtualizeFuncs)
-    pass_manager.add (seahorn::createDevirtualizeFunctionsPass ());
+    early_manager.add (seahorn::createDevirtualizeFunctionsPass ());
   
   // -- externalize uses of address-taken functions
   if (ExternalizeAddrTakenFuncs)
-    pass_manager.add (seahorn::createExternalizeAddressTakenFunctionsPass ());
+    early_manager.add (seahorn::createExternalizeAddressTakenFunctionsPass ());
 
   // kill internal unused code
-  pass_manager.add (llvm::createGlobalDCEPass ()); // kill unused internal global
+  early_manager.add (llvm::createGlobalDCEPass ()); // kill unused internal global
   
   // -- global optimizations
   //pass_manager.add (llvm::createGlobalOptimizerPass());
   
-  // -- SSA
-  pass_manager.add(llvm::createPromoteMemoryToRegisterPass());
-  // -- Turn undef into nondet
-  pass_manager.add (seahorn::createNondetInitPass ());
+  // -- function-level passes. They can run in parallel
+  auto addFunctionPasses = [&] (llvm::PassManager &pm)
+  {
+    // -- SSA
+    pm.add(llvm::createPromoteMemoryToRegisterPass());
+    // -- Turn undef into nondet
+    pm.add (seahorn::createNondetInitPass ());
   
-  // -- cleanup after SSA
-  pass_manager.add (seahorn::createInstCombine ());
-  pass_manager.add (llvm::createCFGSimplificationPass ());
+    // -- cleanup after SSA
+    pm.add (seahorn::createInstCombine ());
+    pm.add (llvm::createCFGSimplificationPass ());
   
-  // -- break aggregates
-  pass_manager.add (llvm::createScalarReplAggregatesPass (SROA_Threshold,
-                                                          true,
-                                                          SROA_StructMemThreshold,
-                                                          SROA_ArrayElementThreshold,
-                                                          SROA_ScalarLoadThreshold));
-  // -- Turn undef into nondet (undef are created by SROA when it calls mem2reg)
-  pass_manager.add (seahorn::createNondetInitPass ());
+    // -- break aggregates
+    pm.add (llvm::createScalarReplAggregatesPass (SROA_Threshold,
+                                                  true,
+                                                  SROA_StructMemThreshold,
+                                                  SROA_ArrayElementThreshold,
+                                                  SROA_ScalarLoadThreshold));
+    // -- Turn undef into nondet (undef are created by SROA when it calls mem2reg)
+    pm.add (seahorn::createNondetInitPass ());
   
-  // -- cleanup after break aggregates
-  pass_manager.add (seahorn::createInstCombine ());
-  pass_manager.add (llvm::createCFGSimplificationPass ());
+    // -- cleanup after break aggregates
+    pm.add (seahorn::createInstCombine ());
+    pm.add (llvm::createCFGSimplificationPass ());
   
-  // eliminate unused calls to verifier.nondet() functions
-  pass_manager.add (seahorn::createDeadNondetElimPass ());
+    // eliminate unused calls to verifier.nondet() functions
+    pm.add (seahorn::createDeadNondetElimPass ());
   
-  pass_manager.add(llvm::createLowerSwitchPass());
+    pm.add(llvm::createLowerSwitchPass());
   
-  pass_manager.add(llvm::createDeadInstEliminationPass());
-  pass_manager.add (new seahorn::RemoveUnreachableBlocksPass ());
+    pm.add(llvm::createDeadInstEliminationPass());
+    pm.add (new seahorn::RemoveUnreachableBlocksPass ());
+  };
+
+  if (Jobs > 1)
+  {
+    module_manager.run (*module.get ());
+    if (!seahorn::runFunctionPassesInParallel (*module, Jobs, addFunctionPasses))
+      return 3;
+  }
+  else
+    addFunctionPasses (pass_manager);
   
   if (InlineAll)
   {
@@ -342,5 +460,12 @@ int main(int argc, char **argv) {
   pass_manager.run(*module.get());
   
   if (!OutputFilename.empty ()) output->keep();
+  if (!cacheFile.empty ())
+  {
+    output->os ().flush ();
+    storeInCache (cacheFile);
+    ufo::Stats::sset ("seapp.cache.entry", cacheFile);
+  }
+  if (PrintStats) ufo::Stats::PrintBrunch (llvm::outs ());
   return 0;
 }
@@ -0,0 +1,119 @@
+#include "seahorn/Support/BitSet.hh"
+
+#include <vector>
+#include <cstdlib>
+
+#define BOOST_TEST_MODULE bitset_test
+#include <boost/test/unit_test.hpp>
+
+using namespace seahorn;
+
+/// a BitSet together with its expected content
+struct Pair
+{
+  BitSet bits;
+  std::vector<bool> ref;
+
+  explicit Pair (unsigned sz) : bits (sz), ref (sz, false) {}
+  void set (unsigned i) { bits.set (i); ref [i] = true; }
+};
+
+static void checkSame (const BitSet &bits, const std::vector<bool> &ref)
+{
+  BOOST_REQUIRE_EQUAL (bits.size (), ref.size ());
+  unsigned cnt = 0;
+  for (unsigned i = 0; i < ref.size (); ++i)
+  {
+    BOOST_CHECK_EQUAL (bits.test (i), ref [i]);
+    if (ref [i]) ++cnt;
+  }
+  BOOST_CHECK_EQUAL (bits.count (), cnt);
+  BOOST_CHECK_EQUAL (bits.any (), cnt > 0);
+
+  // -- iteration visits exactly the set bits, in order
+  std::vector<int> it, ex;
+  for (int i = bits.find_first (); i >= 0; i = bits.find_next (i)) it.push_back (i);
+  for (unsigned i = 0; i < ref.size (); ++i) if (ref [i]) ex.push_back (i);
+  BOOST_CHECK (it == ex);
+}
+
+BOOST_AUTO_TEST_CASE( bitset_empty )
+{
+  BitSet z;
+  BOOST_CHECK_EQUAL (z.size (), 0U);
+  BOOST_CHECK (!z.any ());
+  BOOST_CHECK_EQUAL (z.count (), 0U);
+  BOOST_CHECK_EQUAL (z.find_first (), -1);
+
+  BitSet w (0);
+  BOOST_CHECK (z == w);
+}
+
+BOOST_AUTO_TEST_CASE( bitset_edges )
+{
+  // -- sizes around word and cache-line (512 bit) boundaries
+  const unsigned sizes [] = {1, 63, 64, 65, 511, 512, 513, 1000, 1024, 1537};
+  for (unsigned sz : sizes)
+  {
+    Pair p (sz);
+    p.set (0);
+    p.set (sz - 1);
+    checkSame (p.bits, p.ref);
+    BOOST_CHECK_EQUAL (p.bits.find_next (sz - 1), -1);
+
+    BitSet c (p.bits);
+    BOOST_CHECK (c == p.bits);
+    c.reset (sz - 1);
+    BOOST_CHECK_EQUAL (c.count (), sz > 1 ? 1U : 0U);
+    c.clear ();
+    BOOST_CHECK (!c.any ());
+  }
+}
+
+BOOST_AUTO_TEST_CASE( bitset_random )
+{
+  std::srand (1);
+  for (unsigned t = 0; t < 200; ++t)
+  {
+    unsigned sz = 1 + std::rand () % 1500;
+    Pair a (sz), b (sz), m (sz);
+    for (unsigned i = 0; i < sz; ++i)
+    {
+      if (std::rand () % 3 == 0) a.set (i);
+      if (std::rand () % 3 == 0) b.set (i);
+      if (std::rand () % 2 == 0) m.set (i);
+    }
+
+    // -- this |= b
+    BitSet u (a.bits);
+    std::vector<bool> uref (sz);
+    bool added = false;
+    for (unsigned i = 0; i < sz; ++i)
+    {
+      uref [i] = a.ref [i] || b.ref [i];
+      if (b.ref [i] && !a.ref [i]) added = true;
+    }
+    BOOST_CHECK_EQUAL (u.unionWith (b.bits), added);
+    checkSame (u, uref);
+    // -- nothing left to add
+    BOOST_CHECK (!u.unionWith (b.bits));
+
+    // -- this |= b & ~m
+    BitSet w (a.bits);
+    std::vector<bool> wref (sz);
+    added = false;
+    for (unsigned i = 0; i < sz; ++i)
+    {
+      bool in = b.ref [i] && !m.ref [i];
+      wref [i] = a.ref [i] || in;
+      if (in && !a.ref [i]) added = true;
+    }
+    BOOST_CHECK_EQUAL (w.unionWithout (b.bits, m.bits), added);
+    checkSame (w, wref);
+
+    // -- this &= ~m
+    u.subtract (m.bits);
+    for (unsigned i = 0; i < sz; ++i) uref [i] = uref [i] && !m.ref [i];
+    checkSame (u, uref);
+  }
+}